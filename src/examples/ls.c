@@ -24,38 +24,40 @@ list_dir (const char *dir, bool verbose)
 
   if (isdir (dir_fd))
     {
-      char name[READDIR_MAX_LEN];
+      struct dirent ents[16];
+      int cnt;
 
       printf ("%s", dir);
       if (verbose)
         printf (" (inumber %d)", inumber (dir_fd));
       printf (":\n");
 
-      while (readdir (dir_fd, name)) 
+      while ((cnt = getdents (dir_fd, ents, 16)) > 0) 
         {
-          printf ("%s", name); 
-          if (verbose) 
+          int i;
+
+          for (i = 0; i < cnt; i++) 
             {
-              char full_name[128];
-              int entry_fd;
+              printf ("%s", ents[i].d_name); 
+              if (verbose && ents[i].d_isdir)
+                printf (": directory, inumber %d", ents[i].d_ino);
+              else if (verbose) 
+                {
+                  char full_name[128];
+                  struct stat st;
 
-              snprintf (full_name, sizeof full_name, "%s/%s", dir, name);
-              entry_fd = open (full_name);
+                  snprintf (full_name, sizeof full_name, "%s/%s",
+                            dir, ents[i].d_name);
 
-              printf (": ");
-              if (entry_fd != -1)
-                {
-                  if (isdir (entry_fd))
-                    printf ("directory");
+                  printf (": ");
+                  if (stat (full_name, &st))
+                    printf ("%d-byte file, inumber %d",
+                            st.st_size, st.st_ino);
                   else
-                    printf ("%d-byte file", filesize (entry_fd));
-                  printf (", inumber %d", inumber (entry_fd));
+                    printf ("stat failed");
                 }
-              else
-                printf ("open failed");
-              close (entry_fd);
+              printf ("\n");
             }
-          printf ("\n");
         }
     }
   else 
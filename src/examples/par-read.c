@@ -0,0 +1,110 @@
+/* par-read.c
+
+   Benchmarks concurrent reads.  Creates a file larger than the
+   buffer cache, then runs N copies of itself that each read the
+   whole file ROUNDS times, and waits for all of them.
+
+   Usage: par-read [N]
+
+   There is no user-visible clock, so compare the "Timer: ...
+   ticks" line that the kernel prints at power off for different
+   values of N. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+#define FILE_NAME "par-read.dat"
+#define FILE_SIZE (128 * 1024)
+#define ROUNDS 4
+#define MAX_READERS 16
+
+static char buf[512];
+
+/* Reads FILE_NAME from start to end ROUNDS times. */
+static int
+read_file (void) 
+{
+  int round;
+
+  for (round = 0; round < ROUNDS; round++) 
+    {
+      int fd = open (FILE_NAME);
+      int total = 0;
+      int n;
+
+      if (fd < 0) 
+        {
+          printf ("par-read: open failed\n");
+          return EXIT_FAILURE;
+        }
+      while ((n = read (fd, buf, sizeof buf)) > 0)
+        total += n;
+      close (fd);
+      if (total != FILE_SIZE) 
+        {
+          printf ("par-read: read %d bytes, expected %d\n", total, FILE_SIZE);
+          return EXIT_FAILURE;
+        }
+    }
+  return EXIT_SUCCESS;
+}
+
+/* Creates FILE_NAME with FILE_SIZE bytes of data. */
+static bool
+make_file (void) 
+{
+  int fd, i;
+
+  remove (FILE_NAME);
+  if (!create (FILE_NAME, 0) || (fd = open (FILE_NAME)) < 0)
+    return false;
+  memset (buf, 'x', sizeof buf);
+  for (i = 0; i < FILE_SIZE / (int) sizeof buf; i++)
+    if (write (fd, buf, sizeof buf) != sizeof buf) 
+      {
+        close (fd);
+        return false;
+      }
+  close (fd);
+  return true;
+}
+
+int
+main (int argc, char *argv[]) 
+{
+  pid_t readers[MAX_READERS];
+  int reader_cnt = argc > 1 ? atoi (argv[1]) : 4;
+  int status = EXIT_SUCCESS;
+  int i;
+
+  if (argc > 1 && !strcmp (argv[1], "-c"))
+    return read_file ();
+
+  if (reader_cnt < 1 || reader_cnt > MAX_READERS) 
+    {
+      printf ("usage: par-read [N], where 1 <= N <= %d\n", MAX_READERS);
+      return EXIT_FAILURE;
+    }
+  if (!make_file ()) 
+    {
+      printf ("par-read: could not create %s\n", FILE_NAME);
+      return EXIT_FAILURE;
+    }
+
+  for (i = 0; i < reader_cnt; i++) 
+    {
+      readers[i] = exec ("par-read -c");
+      if (readers[i] == PID_ERROR)
+        status = EXIT_FAILURE;
+    }
+  for (i = 0; i < reader_cnt; i++)
+    if (readers[i] != PID_ERROR && wait (readers[i]) != EXIT_SUCCESS)
+      status = EXIT_FAILURE;
+
+  printf ("par-read: %d readers, %d KB each\n",
+          reader_cnt, ROUNDS * FILE_SIZE / 1024);
+  remove (FILE_NAME);
+  return status;
+}
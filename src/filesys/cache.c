@@ -5,23 +5,42 @@
 #include "devices/block.h"
 #include "devices/timer.h"
 #include "threads/thread.h"
+#include "threads/malloc.h"
 #include <stdio.h>
 #define BUFFER_CACHE 64
 
 static struct cache_entry* cache_lookup (block_sector_t sector);
 static struct cache_entry* cache_evict();
+static struct cache_entry* cache_get (block_sector_t sector, bool load);
+static void cache_put (struct cache_entry *slot);
 struct cache_entry {
 	bool occupied;
 	block_sector_t disk_sector;
 	uint8_t buffer[BLOCK_SECTOR_SIZE];
 	bool dirty;
 	bool lru;
+	int pin_cnt;            // Threads using or waiting for this slot.
+	struct lock lock;       // Held while the buffer is loaded, read or written.
 };
 
 static struct cache_entry cache[BUFFER_CACHE];
 
+// Guards which sector each slot holds, and the lru and pin_cnt
+// fields.  It is held only briefly, so that threads using
+// different sectors, including ones waiting for disk reads, do
+// not wait for each other.
 static struct lock mutex;
 
+// Batches of sectors waiting for the prefetch thread, oldest first,
+// and a condition signaled when one is queued.  One long-lived
+// thread reads them all: a thread started from a user process's
+// system call leaves a child record in that process until it exits.
+static struct list prefetch_queue;
+static struct lock prefetch_lock;
+static struct condition prefetch_ready;
+
+static void cache_prefetch_thread(void *aux UNUSED);
+
 void start_write_back() {
   thread_create("periodically_flush_cache", 0, cache_periodic_write, NULL);
 }
@@ -32,14 +51,20 @@ void cache_init(){
 	int i;
 	for (i = 0; i < BUFFER_CACHE; ++i){
 		cache[i].occupied = false;
+		cache[i].pin_cnt = 0;
+		lock_init(&cache[i].lock);
 	}
+  list_init(&prefetch_queue);
+  lock_init(&prefetch_lock);
+  cond_init(&prefetch_ready);
   start_write_back();
+  thread_create("cache_prefetch", PRI_DEFAULT, cache_prefetch_thread, NULL);
 }
 
 
 //flush the given entry back to required disk_sector
 static void cache_flush(struct cache_entry *entry){
-	ASSERT(lock_held_by_current_thread(&mutex));
+	ASSERT(lock_held_by_current_thread(&entry->lock));
 	ASSERT(entry != NULL && entry->occupied == true);
 	if (entry->dirty){
 		block_write(fs_device, entry->disk_sector, entry->buffer);
@@ -48,16 +73,7 @@ static void cache_flush(struct cache_entry *entry){
 }
 
 void cache_destroy() {
-  lock_acquire(&mutex);
-
-  size_t i = 0;
-  for (i = 0; i < BUFFER_CACHE; i++) {
-    if (!cache[i].occupied) {
-      continue;
-    }
-    cache_flush(&(cache[i]));
-  }
-  lock_release(&mutex);
+  flush_entire_cache();
 }
 
 
@@ -65,6 +81,7 @@ void cache_destroy() {
 //lookup the given entry in cache buffer and return
 // the required buffer else return NULL
 static struct cache_entry* cache_lookup (block_sector_t sector){
+	ASSERT(lock_held_by_current_thread(&mutex));
 	int i;
 	for (i = 0; i < BUFFER_CACHE; ++i){
 		if (cache[i].occupied == false){
@@ -78,35 +95,97 @@ static struct cache_entry* cache_lookup (block_sector_t sector){
   //cache miss
   return NULL;
 }
-//return free slot else evict a slot by implementing clock algo
+//return free slot else evict a slot by implementing clock algo.
+//Slots in use are skipped; returns NULL if every slot is in use.
+//A dirty victim is returned still occupied, for the caller to
+//write back without holding MUTEX.
 static struct cache_entry* cache_evict(){
 	ASSERT(lock_held_by_current_thread(&mutex));
 	
 	//implement clock algo
 	static int clock = 0;
-	while(true){
-		if (cache[clock].occupied == false){
+	int tries;
+	for (tries = 0; tries < 2 * BUFFER_CACHE; tries++){
+		struct cache_entry *slot = &cache[clock];
+		clock = (clock + 1) % BUFFER_CACHE;
+		if (slot->occupied == false){
 			//empty slot
-			return &(cache[clock]);
+			return slot;
+		}
+		if (slot->pin_cnt > 0){
+			continue;
 		}
-		if (cache[clock].lru){
+		if (slot->lru){
 			//second chance to evict
-			cache[clock].lru = false;
+			slot->lru = false;
+			continue;
 		}
-		//if not lru then return this slot
-		else break;
-		clock++;
-		clock = clock % BUFFER_CACHE;
+		//if not lru then evict this slot
+		if(!slot->dirty)
+			slot->occupied = false;
+		return slot;
 	}
-	struct cache_entry *slot = &cache[clock];
-	if(slot->dirty){
-		//flush to disk
-		cache_flush(slot);
+	return NULL;
+}
+
+// Returns the slot holding SECTOR, pinned and locked, reading it
+// from disk first if it is not cached.  If LOAD is false, the
+// caller is about to overwrite the whole sector, so a newly
+// cached sector is not read.  Release with cache_put().
+static struct cache_entry* cache_get (block_sector_t sector, bool load){
+	struct cache_entry *slot;
+
+	lock_acquire(&mutex);
+	while ((slot = cache_lookup(sector)) == NULL){
+		slot = cache_evict(); //evict slot
+		if (slot != NULL && slot->occupied){
+			// Write the dirty victim back pinned, so that nobody
+			// evicts it and users of its sector wait on its lock
+			// instead of reading stale data from disk.  Then look
+			// again: SECTOR may have been cached meanwhile.
+			slot->pin_cnt++;
+			lock_release(&mutex);
+			lock_acquire(&slot->lock);
+			cache_flush(slot);
+			cache_put(slot);
+			lock_acquire(&mutex);
+			continue;
+		}
+		if (slot != NULL){
+			ASSERT(slot->occupied == false && slot->pin_cnt == 0);
+			slot->occupied = true;
+			slot->disk_sector = sector;
+			slot->dirty = false;
+			slot->lru = true;
+			slot->pin_cnt = 1;
+			// Other threads that want SECTOR wait on the slot's
+			// lock, not on MUTEX, while it is read.
+			lock_acquire(&slot->lock);
+			lock_release(&mutex);
+			if (load)
+				block_read(fs_device, sector, slot->buffer);
+			return slot;
+		}
+		//every slot is in use: let their users finish
+		lock_release(&mutex);
+		thread_yield();
+		lock_acquire(&mutex);
 	}
-	slot->occupied = false;
+	slot->pin_cnt++;
+	slot->lru = true;
+	lock_release(&mutex);
+	lock_acquire(&slot->lock);
 	return slot;
 }
 
+// Unlocks and unpins SLOT, which was returned by cache_get().
+static void cache_put (struct cache_entry *slot){
+	lock_release(&slot->lock);
+	lock_acquire(&mutex);
+	slot->pin_cnt--;
+	lock_release(&mutex);
+}
+
 //read into empty cache buffer's slot or evict and write to that slot
 void cache_read(block_sector_t sector, void *target){
   cache_read_partial(sector, target, 0, BLOCK_SECTOR_SIZE);
@@ -117,47 +196,60 @@ void cache_read(block_sector_t sector, void *target){
 // reading from, as well as the length of the read.
 void cache_read_partial(block_sector_t sector, void *target, 
                         size_t ofs, size_t length) {
-  lock_acquire(&mutex);
   ASSERT(length <= BLOCK_SECTOR_SIZE);
   ASSERT(ofs < BLOCK_SECTOR_SIZE);
-  struct cache_entry *slot = cache_lookup(sector); //check entry
-	//if not found
-	if (slot == NULL){
-		slot = cache_evict(); //evict slot
-		ASSERT(slot != NULL && slot->occupied == false);
-		slot->occupied = true;
-		slot->disk_sector = sector;
-		slot->dirty = false;
-		block_read(fs_device, sector, slot->buffer);
-	}
+  struct cache_entry *slot = cache_get(sector, true);
 	//copy data from cache slot to memory
-	slot->lru = true;
 	memcpy(target, slot->buffer + ofs, length);
-	lock_release(&mutex);
+	cache_put(slot);
+}
 
+// Starts reading SECTOR into the cache, through the prefetch
+// thread, and returns without waiting for it.
+void cache_read_ahead(block_sector_t sector) {
+  cache_prefetch(&sector, 1);
 }
 
-void cache_access(void* sectorPtr){
-  lock_acquire(&mutex);
-  block_sector_t sector = *(block_sector_t*)sectorPtr;
-	struct cache_entry *slot = cache_lookup(sector); //check entry
-	//if not found
-	if (slot == NULL){
-		slot = cache_evict(); //evict slot
-		ASSERT(slot != NULL && slot->occupied == false);
-		slot->occupied = true;
-		slot->disk_sector = sector;
-		slot->dirty = false;
-		block_read(fs_device, sector, slot->buffer);
-	}
-	slot->lru = true;
-  lock_release(&mutex);
+// A batch of sectors for the prefetch thread to read.
+struct prefetch_args {
+  struct list_elem elem;  // Element in prefetch_queue.
+  size_t cnt;
+  block_sector_t sectors[];
+};
+
+// Reads the batches that cache_prefetch() queues, forever.
+static void cache_prefetch_thread(void *aux UNUSED) {
+  for (;;) {
+    struct prefetch_args *args;
+    size_t i;
+    lock_acquire(&prefetch_lock);
+    while (list_empty(&prefetch_queue))
+      cond_wait(&prefetch_ready, &prefetch_lock);
+    args = list_entry(list_pop_front(&prefetch_queue),
+                      struct prefetch_args, elem);
+    lock_release(&prefetch_lock);
+    for (i = 0; i < args->cnt; i++)
+      cache_put(cache_get(args->sectors[i], true));
+    free(args);
+  }
 }
 
-void cache_read_ahead(block_sector_t sector) {
-  block_sector_t *sectorPtr = malloc(sizeof(block_sector_t));
-  *sectorPtr = sector;
-  thread_create("cache_read_ahead", 0, cache_access, sectorPtr);
+// Starts reading the CNT sectors in SECTORS into the cache, in
+// order, and returns without waiting for them.  No thread is
+// created: the batch is queued for the prefetch thread.
+void cache_prefetch(const block_sector_t *sectors, size_t cnt) {
+  struct prefetch_args *args;
+  if (cnt == 0)
+    return;
+  args = malloc(sizeof *args + cnt * sizeof *sectors);
+  if (args == NULL)
+    return;
+  args->cnt = cnt;
+  memcpy(args->sectors, sectors, cnt * sizeof *sectors);
+  lock_acquire(&prefetch_lock);
+  list_push_back(&prefetch_queue, &args->elem);
+  cond_signal(&prefetch_ready, &prefetch_lock);
+  lock_release(&prefetch_lock);
 }
 
 //write data from memory to cache and then to the disk
@@ -170,22 +262,12 @@ void cache_write(block_sector_t sector, const void *source){
 // writing from, as well as the length of the write.
 void cache_write_partial(block_sector_t sector, const void *source,
                           size_t ofs, size_t length) {
-	lock_acquire(&mutex);
   ASSERT(length <= BLOCK_SECTOR_SIZE);
   ASSERT(ofs < BLOCK_SECTOR_SIZE);
-	struct cache_entry *slot = cache_lookup(sector);
-	if (slot == NULL){
-		slot = cache_evict ();
-		ASSERT(slot != NULL && slot->occupied == false);
-		slot->occupied = true;
-		slot->disk_sector = sector;
-		slot->dirty = false;
-		block_read(fs_device, sector, slot->buffer);
-	}
-	slot->lru = true;
+	struct cache_entry *slot = cache_get(sector, length < BLOCK_SECTOR_SIZE);
 	slot->dirty = true;
 	memcpy(slot->buffer + ofs, source, length);
-	lock_release(&mutex);
+	cache_put(slot);
 }
 
 void cache_periodic_write(void *aux UNUSED) {
@@ -196,14 +278,19 @@ void cache_periodic_write(void *aux UNUSED) {
 }
 
 void flush_entire_cache() {
-  lock_acquire(&mutex);
   size_t i;
   for (i = 0; i < BUFFER_CACHE; i++) {
-    if (!cache[i].occupied) {
+    struct cache_entry *slot = &cache[i];
+    lock_acquire(&mutex);
+    if (!slot->occupied || !slot->dirty) {
+      lock_release(&mutex);
       continue;
-    } else if (cache[i].dirty) {
-      cache_flush(&(cache[i]));
     }
+    slot->pin_cnt++;
+    lock_release(&mutex);
+
+    lock_acquire(&slot->lock);
+    cache_flush(slot);
+    cache_put(slot);
   }
-  lock_release(&mutex);
 }
@@ -0,0 +1,121 @@
+#include "filesys/dentry.h"
+#include <hash.h>
+#include <string.h>
+#include "filesys/directory.h"
+#include "threads/synch.h"
+
+/* Directory entry cache.
+
+   Maps a (parent directory sector, name) pair to the sector of
+   the child's inode, so that resolving a path component that
+   was recently looked up does not scan the parent directory.
+   A lookup that failed is cached too, as a negative entry whose
+   child is DENTRY_NEGATIVE.
+
+   The cache is a direct-mapped table: a new entry simply
+   replaces whatever was in its slot.  Every change to a
+   directory's contents must go through dir_add() or dir_remove(),
+   which keep the cache consistent. */
+#define DENTRY_CNT 256
+
+struct dentry
+  {
+    bool valid;                         /* In use? */
+    block_sector_t parent;              /* Parent directory's inode. */
+    block_sector_t child;               /* Child's inode, or negative. */
+    char name[NAME_MAX + 1];            /* Null terminated name. */
+  };
+
+static struct dentry dentries[DENTRY_CNT];
+static struct lock dentry_lock;
+
+/* Returns the slot for NAME in PARENT. */
+static struct dentry *
+dentry_slot (block_sector_t parent, const char *name) 
+{
+  return &dentries[(hash_string (name) ^ hash_int (parent)) % DENTRY_CNT];
+}
+
+/* Returns true if D is the entry for NAME in PARENT. */
+static bool
+dentry_matches (const struct dentry *d, block_sector_t parent,
+                const char *name) 
+{
+  return d->valid && d->parent == parent && !strcmp (d->name, name);
+}
+
+/* Initializes the directory entry cache. */
+void
+dentry_init (void) 
+{
+  lock_init (&dentry_lock);
+  memset (dentries, 0, sizeof dentries);
+}
+
+/* Looks up NAME in the directory whose inode is in PARENT.
+   Returns true if the cache knows the answer, setting *CHILD to
+   the child's inode sector or to DENTRY_NEGATIVE if PARENT has
+   no entry NAME.  Returns false on a cache miss. */
+bool
+dentry_lookup (block_sector_t parent, const char *name,
+               block_sector_t *child) 
+{
+  struct dentry *d = dentry_slot (parent, name);
+  bool hit;
+
+  lock_acquire (&dentry_lock);
+  hit = dentry_matches (d, parent, name);
+  if (hit)
+    *child = d->child;
+  lock_release (&dentry_lock);
+  return hit;
+}
+
+/* Records that NAME in the directory whose inode is in PARENT
+   refers to CHILD, which may be DENTRY_NEGATIVE.  Names too long
+   to be valid are not cached. */
+void
+dentry_insert (block_sector_t parent, const char *name,
+               block_sector_t child) 
+{
+  struct dentry *d = dentry_slot (parent, name);
+
+  if (strlen (name) > NAME_MAX)
+    return;
+
+  lock_acquire (&dentry_lock);
+  d->valid = true;
+  d->parent = parent;
+  d->child = child;
+  strlcpy (d->name, name, sizeof d->name);
+  lock_release (&dentry_lock);
+}
+
+/* Forgets anything cached about NAME in the directory whose
+   inode is in PARENT. */
+void
+dentry_invalidate (block_sector_t parent, const char *name) 
+{
+  struct dentry *d = dentry_slot (parent, name);
+
+  lock_acquire (&dentry_lock);
+  if (dentry_matches (d, parent, name))
+    d->valid = false;
+  lock_release (&dentry_lock);
+}
+
+/* Forgets every entry whose parent is the directory in PARENT.
+   Called when a new directory is created in PARENT, so that it
+   does not inherit entries cached for a removed directory that
+   used the same sector. */
+void
+dentry_invalidate_dir (block_sector_t parent) 
+{
+  size_t i;
+
+  lock_acquire (&dentry_lock);
+  for (i = 0; i < DENTRY_CNT; i++)
+    if (dentries[i].valid && dentries[i].parent == parent)
+      dentries[i].valid = false;
+  lock_release (&dentry_lock);
+}
@@ -0,0 +1,20 @@
+#ifndef FILESYS_DENTRY_H
+#define FILESYS_DENTRY_H
+
+#include <stdbool.h>
+#include "devices/block.h"
+
+/* Child sector recorded by a negative entry, which says that a
+   directory has no entry by a given name.  Sector 0 holds the
+   free map's inode, so it is never a directory entry. */
+#define DENTRY_NEGATIVE ((block_sector_t) 0)
+
+void dentry_init (void);
+bool dentry_lookup (block_sector_t parent, const char *name,
+                    block_sector_t *child);
+void dentry_insert (block_sector_t parent, const char *name,
+                    block_sector_t child);
+void dentry_invalidate (block_sector_t parent, const char *name);
+void dentry_invalidate_dir (block_sector_t parent);
+
+#endif /* filesys/dentry.h */
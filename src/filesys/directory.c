@@ -1,7 +1,9 @@
 #include "filesys/directory.h"
 #include <stdio.h>
 #include <string.h>
+#include <hash.h>
 #include <list.h>
+#include "filesys/dentry.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
@@ -22,15 +24,77 @@ struct dir_entry
     bool in_use;                        /* In use or free? */
   };
 
+/* Directory formats.
+
+   A linear directory is an unordered array of entries that is
+   searched from start to end.
+
+   A hashed directory is an open addressing hash table of
+   SLOT_CNT entries keyed by hash_string() of the name, with
+   linear probing.  A lookup starts at the name's home slot and
+   stops at the first slot that has never been used, so lookups
+   and inserts touch O(1) sectors.  Removed entries are left
+   behind with in_use false but inode_sector still set, so that
+   probe chains stay intact.  The table is rebuilt at double size
+   once 3/4 of its slots have been used.
+
+   Directories start out linear and are rebuilt as hashed once
+   they outgrow DIR_HASH_MIN_SLOTS slots.  Either way, every slot
+   is a struct dir_entry, so readdir works the same.
+
+   The header counts the live entries, so checking whether a
+   directory is empty reads only the header.  A linear directory's
+   header also records a slot below which no slot is free, where
+   dir_add starts looking for room. */
+#define DIR_LINEAR 0
+#define DIR_HASHED 0x48534844           /* "DHSH". */
+#define DIR_HASH_MIN_SLOTS 32
+
+/* Directory header, stored in place of the first entry.
+   Must be the same size as struct dir_entry. */
+struct dir_header
+  {
+    block_sector_t parent_sector;       /* Parent directory's inode. */
+    uint32_t format;                    /* DIR_HASHED, else linear. */
+    uint32_t live_cnt;                  /* Entries in use. */
+    union
+      {
+        uint32_t free_hint;             /* Linear: no free slot below. */
+        uint32_t slot_cnt;              /* Hashed: number of slots. */
+      };
+    uint32_t used_cnt;                  /* Hashed: slots ever used. */
+  };
+
+static bool read_header (const struct dir *, struct dir_header *);
+static bool write_header (struct inode *, const struct dir_header *);
+static bool dir_rehash (struct dir *, struct dir_header *);
+
+/* Returns the byte offset of entry slot SLOT in a directory. */
+static inline off_t
+slot_to_ofs (size_t slot) 
+{
+  return (slot + 1) * sizeof (struct dir_entry);
+}
+
+/* Returns the entry slot at byte offset OFS in a directory. */
+static inline size_t
+ofs_to_slot (off_t ofs) 
+{
+  return ofs / sizeof (struct dir_entry) - 1;
+}
+
   
   
   
   
   
-//separate path
-void separate_path (const char *path, char *dir, char *filename){
+//separate path.  Returns false if out of memory.  PATH may be a
+//page long, so it is not copied onto the stack.
+bool separate_path (const char *path, char *dir, char *filename){
 	int path_length = strlen(path);
-	char *temp_path = (char *) malloc (sizeof (char)*(path_length + 1));
+	char *temp_path = malloc (sizeof (char) * (path_length + 1));
+	if (temp_path == NULL)
+		return false;
 	memcpy (temp_path, path, sizeof (char) * (path_length + 1));
 	//absolute path
 	char *temp_dir = dir;
@@ -56,7 +120,8 @@ void separate_path (const char *path, char *dir, char *filename){
 	}
 	if (temp_dir) *temp_dir = '\0';
 	memcpy (filename, last_token, sizeof (char) * (strlen(last_token) + 1));
-	free(temp_path);
+	free (temp_path);
+	return true;
 }
 /* Creates a directory with space for ENTRY_CNT entries in the
    given SECTOR.  Returns true if successful, false on failure. */
@@ -66,11 +131,11 @@ dir_create (block_sector_t sector, size_t entry_cnt)
 	bool success = true;
 	success = inode_create (sector, entry_cnt * sizeof (struct dir_entry), true);
 	if (!success) return false;
+	dentry_invalidate_dir (sector);
 	
 	struct dir *dir = dir_open (inode_open (sector));
-	struct dir_entry e;
-	e.inode_sector = sector;
-	if (inode_write_at (dir->inode, &e, sizeof e, 0) != sizeof e){
+	struct dir_header h = { .parent_sector = sector, .format = DIR_LINEAR };
+	if (!write_header (dir->inode, &h)){
 		success = false;
 	}
 	dir_close (dir);
@@ -108,6 +173,12 @@ dir_open_root (void)
 
 //open directory 
 struct dir * open_dir (const char *path){
+	return open_dir_at (NULL, path);
+}
+
+/* Opens the directory named PATH.  A relative PATH is resolved
+   from BASE, or from the current directory if BASE is null. */
+struct dir * open_dir_at (struct dir *base, const char *path){
 	int path_length = strlen (path);
 	char temp_path[path_length + 1];
 	strlcpy (temp_path, path, path_length + 1);
@@ -118,6 +189,10 @@ struct dir * open_dir (const char *path){
 	if (path[0] == '/'){
 		cur_dir = dir_open_root();
 	}
+	else if (base != NULL)
+	{
+		cur_dir = dir_reopen (base);
+	}
 	else
 	{
 		struct thread *t = thread_current();
@@ -187,6 +262,158 @@ dir_get_inode (struct dir *dir)
   return dir->inode;
 }
 
+/* Sets the position from which dir_readdir() reads its next entry
+   in DIR to POS, as returned earlier by dir_tell(). */
+void
+dir_seek (struct dir *dir, off_t pos) 
+{
+  dir->pos = pos;
+}
+
+/* Returns the position from which dir_readdir() reads its next
+   entry in DIR. */
+off_t
+dir_tell (struct dir *dir) 
+{
+  return dir->pos;
+}
+
+/* Reads DIR's header into *H.  Returns true if successful. */
+static bool
+read_header (const struct dir *dir, struct dir_header *h) 
+{
+  ASSERT (sizeof *h == sizeof (struct dir_entry));
+  return inode_read_at (dir->inode, h, sizeof *h, 0) == sizeof *h;
+}
+
+/* Writes H as the header of the directory in INODE.  Returns true
+   if successful. */
+static bool
+write_header (struct inode *inode, const struct dir_header *h) 
+{
+  return inode_write_at (inode, h, sizeof *h, 0) == sizeof *h;
+}
+
+/* Searches hashed directory DIR, whose header is H, for an entry
+   named NAME, following NAME's probe chain.  Returns and stores
+   results as lookup() does. */
+static bool
+hashed_lookup (const struct dir *dir, const struct dir_header *h,
+               const char *name, struct dir_entry *ep, off_t *ofsp) 
+{
+  struct dir_entry e;
+  size_t slot = hash_string (name) % h->slot_cnt;
+  size_t i;
+
+  for (i = 0; i < h->slot_cnt; i++) 
+    {
+      off_t ofs = slot_to_ofs (slot);
+      if (inode_read_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
+        break;
+      if (e.in_use && !strcmp (name, e.name)) 
+        {
+          if (ep != NULL)
+            *ep = e;
+          if (ofsp != NULL)
+            *ofsp = ofs;
+          return true;
+        }
+      if (!e.in_use && e.inode_sector == 0)
+        break;
+      slot = (slot + 1) % h->slot_cnt;
+    }
+  return false;
+}
+
+/* Returns the offset of the slot where an entry named NAME goes
+   in hashed directory DIR, whose header is H: the first free slot
+   on NAME's probe chain.  Sets *FRESH to true if the slot has
+   never been used, false if it held a removed entry.  H must have
+   at least one free slot. */
+static off_t
+hashed_free_slot (const struct dir *dir, const struct dir_header *h,
+                  const char *name, bool *fresh) 
+{
+  struct dir_entry e;
+  size_t slot = hash_string (name) % h->slot_cnt;
+
+  for (;;) 
+    {
+      off_t ofs = slot_to_ofs (slot);
+      if (inode_read_at (dir->inode, &e, sizeof e, ofs) != sizeof e
+          || (!e.in_use && e.inode_sector == 0))
+        {
+          *fresh = true;
+          return ofs;
+        }
+      if (!e.in_use)
+        {
+          *fresh = false;
+          return ofs;
+        }
+      slot = (slot + 1) % h->slot_cnt;
+    }
+}
+
+/* Rebuilds DIR, linear or hashed, as a hashed directory whose
+   live entries fill at most half of its slots, and updates *H to
+   match.  Returns true if successful.  On failure, which happens
+   only if memory or disk space runs out, DIR is unchanged. */
+static bool
+dir_rehash (struct dir *dir, struct dir_header *h) 
+{
+  static const char zeros[BLOCK_SECTOR_SIZE];
+  struct dir_entry e;
+  struct dir_entry *live;
+  size_t live_cnt = 0;
+  size_t slot_cnt, i;
+  off_t ofs, end;
+
+  /* Save the live entries. */
+  live = malloc (inode_length (dir->inode));
+  if (live == NULL)
+    return false;
+  for (ofs = sizeof e; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+       ofs += sizeof e)
+    if (e.in_use)
+      live[live_cnt++] = e;
+
+  /* Grow the file first, since that is the only step that can
+     fail, then clear every slot. */
+  slot_cnt = 2 * (live_cnt + 1);
+  if (slot_cnt < 2 * DIR_HASH_MIN_SLOTS)
+    slot_cnt = 2 * DIR_HASH_MIN_SLOTS;
+  end = slot_to_ofs (slot_cnt);
+  if (end < inode_length (dir->inode))
+    end = inode_length (dir->inode);
+  if (inode_write_at (dir->inode, zeros, sizeof e, end - sizeof e) != sizeof e)
+    {
+      free (live);
+      return false;
+    }
+  for (ofs = sizeof e; ofs < end; ofs += sizeof zeros)
+    {
+      off_t chunk = end - ofs;
+      if (chunk > (off_t) sizeof zeros)
+        chunk = sizeof zeros;
+      inode_write_at (dir->inode, zeros, chunk, ofs);
+    }
+
+  /* Reinsert the live entries. */
+  h->format = DIR_HASHED;
+  h->live_cnt = live_cnt;
+  h->slot_cnt = slot_cnt;
+  h->used_cnt = live_cnt;
+  for (i = 0; i < live_cnt; i++)
+    {
+      bool fresh;
+      ofs = hashed_free_slot (dir, h, live[i].name, &fresh);
+      inode_write_at (dir->inode, &live[i], sizeof live[i], ofs);
+    }
+  free (live);
+  return write_header (dir->inode, h);
+}
+
 /* Searches DIR for a file with the given NAME.
    If successful, returns true, sets *EP to the directory entry
    if EP is non-null, and sets *OFSP to the byte offset of the
@@ -196,12 +423,16 @@ static bool
 lookup (const struct dir *dir, const char *name,
         struct dir_entry *ep, off_t *ofsp) 
 {
+  struct dir_header h;
   struct dir_entry e;
   size_t ofs;
   
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
+  if (read_header (dir, &h) && h.format == DIR_HASHED)
+    return hashed_lookup (dir, &h, name, ep, ofsp);
+
   for (ofs = sizeof e; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
        ofs += sizeof e) 
     if (e.in_use && !strcmp (name, e.name)) 
@@ -220,16 +451,8 @@ lookup (const struct dir *dir, const char *name,
 //whether directory is empty
 bool isEmpty (const struct dir *dir)
 {
-	struct dir_entry e;
-	off_t ofs;
-	
-	for (ofs = sizeof e; inode_read_at (dir->inode, &e,sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
-	{
-		if (e.in_use)
-			return false;
-	}
-	return true;
+	struct dir_header h;
+	return read_header (dir, &h) && h.live_cnt == 0;
 }
 /* Searches DIR for a file with the given NAME
    and returns true if one exists, false otherwise.
@@ -244,21 +467,32 @@ dir_lookup (const struct dir *dir, const char *name,
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
+	inode_lock_dir (dir->inode, false);
 	if (strcmp (name, ".") == 0)
 	{
 		*inode = inode_reopen (dir->inode);
 	}
 	else if (strcmp (name, "..") == 0)
 	{
-		inode_read_at (dir->inode, &e, sizeof e, 0);
-		*inode = inode_open (e.inode_sector);
+		struct dir_header h;
+		if (read_header (dir, &h))
+			*inode = inode_open (h.parent_sector);
+		else
+			*inode = NULL;
 	}
-	else if (lookup (dir, name, &e, NULL))
-		*inode = inode_open (e.inode_sector);
 	else
-{
-		*inode = NULL;
-}
+	{
+		/* Consult the dentry cache before scanning DIR. */
+		block_sector_t parent = inode_get_inumber (dir->inode);
+		block_sector_t child;
+		if (!dentry_lookup (parent, name, &child))
+		{
+			child = lookup (dir, name, &e, NULL) ? e.inode_sector : DENTRY_NEGATIVE;
+			dentry_insert (parent, name, child);
+		}
+		*inode = child != DENTRY_NEGATIVE ? inode_open (child) : NULL;
+	}
+	inode_unlock_dir (dir->inode);
 
   return *inode != NULL;
 }
@@ -275,8 +509,12 @@ dir_lookup (const struct dir *dir, const char *name,
 bool
 dir_add (struct dir *dir, const char *name, block_sector_t inode_sector, bool isDir)
 {
+  struct dir_header h;
   struct dir_entry e;
+  block_sector_t parent, child;
+  bool in_use;
   off_t ofs;
+  bool fresh = false;
   bool success = false;
 
   ASSERT (dir != NULL);
@@ -286,8 +524,22 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector, bool is
   if (*name == '\0' || strlen (name) > NAME_MAX)
     return false;
 
-  /* Check that NAME is not in use. */
-  if (lookup (dir, name, NULL, NULL))
+  /* Nothing may be added to a directory that has been removed. */
+  inode_lock_dir (dir->inode, true);
+  if (inode_is_removed (dir->inode))
+    goto done;
+
+  /* Check that NAME is not in use.  A cached negative entry saves
+     scanning DIR. */
+  parent = inode_get_inumber (dir->inode);
+  if (dentry_lookup (parent, name, &child))
+    in_use = child != DENTRY_NEGATIVE;
+  else
+    in_use = lookup (dir, name, NULL, NULL);
+  if (in_use)
+    goto done;
+  dentry_invalidate (parent, name);
+  if (!read_header (dir, &h))
     goto done;
 
 // update the child directory
@@ -295,8 +547,11 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector, bool is
  {
 	 struct dir *childDir = dir_open (inode_open (inode_sector));
 	 if (childDir == NULL) goto done;
-	 e.inode_sector = inode_get_inumber (dir_get_inode(dir));
-	 if (inode_write_at (childDir -> inode, &e, sizeof e, 0) != sizeof e)
+	 struct dir_header child_h = {
+	   .parent_sector = inode_get_inumber (dir_get_inode(dir)),
+	   .format = DIR_LINEAR
+	 };
+	 if (!write_header (childDir -> inode, &child_h))
 	 {
 		 dir_close (childDir);
 		 goto done;
@@ -304,25 +559,55 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector, bool is
 	 dir_close (childDir);
  }
  
-  /* Set OFS to offset of free slot.
-     If there are no free slots, then it will be set to the
-     current end-of-file.
-     
-     inode_read_at() will only return a short read at end of file.
-     Otherwise, we'd need to verify that we didn't get a short
-     read due to something intermittent such as low memory. */
-  for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-       ofs += sizeof e) 
-    if (!e.in_use)
-      break;
+  if (h.format != DIR_HASHED)
+    {
+      /* Set OFS to offset of free slot, starting from the header's
+         hint, below which every slot is in use.
+         If there are no free slots, then it will be set to the
+         current end-of-file.
+         
+         inode_read_at() will only return a short read at end of file.
+         Otherwise, we'd need to verify that we didn't get a short
+         read due to something intermittent such as low memory. */
+      for (ofs = slot_to_ofs (h.free_hint);
+           inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+           ofs += sizeof e) 
+        if (!e.in_use)
+          break;
+
+      /* A directory that outgrows a linear scan becomes hashed.
+         If that fails, it can still grow linearly. */
+      if (ofs >= slot_to_ofs (DIR_HASH_MIN_SLOTS))
+        dir_rehash (dir, &h);
+    }
+  if (h.format == DIR_HASHED)
+    {
+      if ((h.used_cnt + 1) * 4 > h.slot_cnt * 3
+          && !dir_rehash (dir, &h)
+          && h.used_cnt == h.slot_cnt)
+        goto done;
+      ofs = hashed_free_slot (dir, &h, name, &fresh);
+    }
 
   /* Write slot. */
   e.in_use = true;
   strlcpy (e.name, name, sizeof e.name);
   e.inode_sector = inode_sector;
   success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+  if (success)
+    {
+      h.live_cnt++;
+      if (h.format != DIR_HASHED)
+        h.free_hint = ofs_to_slot (ofs) + 1;
+      else if (fresh)
+        h.used_cnt++;
+      success = write_header (dir->inode, &h);
+    }
+  if (success)
+    dentry_insert (parent, name, inode_sector);
 
  done:
+  inode_unlock_dir (dir->inode);
   return success;
 }
 
@@ -332,14 +617,18 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector, bool is
 bool
 dir_remove (struct dir *dir, const char *name) 
 {
+  struct dir_header h;
   struct dir_entry e;
   struct inode *inode = NULL;
+  bool child_locked = false;
   bool success = false;
   off_t ofs;
 
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
+  inode_lock_dir (dir->inode, true);
+
   /* Find directory entry. */
   if (!lookup (dir, name, &e, &ofs))
     goto done;
@@ -349,26 +638,39 @@ dir_remove (struct dir *dir, const char *name)
   if (inode == NULL)
     goto done;
 
-//do not allow to remove non-empty directory
+//do not allow to remove non-empty directory.  Holding its lock
+//until it is marked removed keeps anything from being added.
  if (inode_is_dir (inode))
  {
-	 struct dir *target = dir_open (inode);
+	 inode_lock_dir (inode, true);
+	 child_locked = true;
+	 struct dir *target = dir_open (inode_reopen (inode));
 	 bool emptyDir = isEmpty (target);
 	 dir_close (target);
 	 if (!emptyDir) goto done;
  }
  
   /* Erase directory entry. */
+  if (!read_header (dir, &h))
+    goto done;
+  dentry_invalidate (inode_get_inumber (dir->inode), name);
   e.in_use = false;
   if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e) 
     goto done;
+  h.live_cnt--;
+  if (h.format != DIR_HASHED && ofs_to_slot (ofs) < h.free_hint)
+    h.free_hint = ofs_to_slot (ofs);
+  write_header (dir->inode, &h);
 
   /* Remove inode. */
   inode_remove (inode);
   success = true;
 
  done:
+  if (child_locked)
+    inode_unlock_dir (inode);
   inode_close (inode);
+  inode_unlock_dir (dir->inode);
   return success;
 }
 
@@ -377,18 +679,33 @@ dir_remove (struct dir *dir, const char *name)
    contains no more entries. */
 bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1])
+{
+  return dir_readdir_inumber (dir, name, NULL);
+}
+
+/* Like dir_readdir(), but also stores the entry's inode sector in
+   *SECTOR if SECTOR is non-null. */
+bool
+dir_readdir_inumber (struct dir *dir, char name[NAME_MAX + 1],
+                     block_sector_t *sector)
 {
   struct dir_entry e;
+  bool found = false;
 
+  inode_lock_dir (dir->inode, false);
   while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) 
     {
       dir->pos += sizeof e;
       if (e.in_use)
         {
           strlcpy (name, e.name, NAME_MAX + 1);
-          return true;
+          if (sector != NULL)
+            *sector = e.inode_sector;
+          found = true;
+          break;
         } 
     }
-  return false;
+  inode_unlock_dir (dir->inode);
+  return found;
 }
 
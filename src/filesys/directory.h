@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "devices/block.h"
+#include "filesys/off_t.h"
 
 /* Maximum length of a file name component.
    This is the traditional UNIX maximum length.
@@ -20,14 +21,19 @@ struct dir *dir_open_root (void);
 struct dir *dir_reopen (struct dir *);
 void dir_close (struct dir *);
 struct inode *dir_get_inode (struct dir *);
+void dir_seek (struct dir *, off_t);
+off_t dir_tell (struct dir *);
 
 /* Reading and writing. */
 bool dir_lookup (const struct dir *, const char *name, struct inode **);
 bool dir_add (struct dir *, const char *name, block_sector_t, bool);
 bool dir_remove (struct dir *, const char *name);
 bool dir_readdir (struct dir *, char name[NAME_MAX + 1]);
-void separate_path (const char *path, char *dir, char *filename);
+bool dir_readdir_inumber (struct dir *, char name[NAME_MAX + 1],
+                          block_sector_t *);
+bool separate_path (const char *path, char *dir, char *filename);
 struct dir * open_dir (const char *path);
+struct dir * open_dir_at (struct dir *base, const char *path);
 
 #endif /* filesys/directory.h */
 
@@ -1,5 +1,6 @@
 #include "filesys/file.h"
 #include <debug.h>
+#include <uio.h>
 #include "filesys/inode.h"
 #include "threads/malloc.h"
 
@@ -113,6 +114,62 @@ file_write_at (struct file *file, const void *buffer, off_t size,
   return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Reads into the IOV_CNT buffers in IOV, in order, from FILE,
+   starting at the file's current position, and advances the
+   position.  Stops at the first buffer that is not filled.
+   Returns the number of bytes actually read. */
+off_t
+file_readv (struct file *file, const struct iovec *iov, int iov_cnt) 
+{
+  off_t bytes_read = 0;
+  int i;
+
+  for (i = 0; i < iov_cnt; i++) 
+    {
+      off_t n = inode_read_at (file->inode, iov[i].iov_base,
+                               iov[i].iov_len, file->pos);
+      file->pos += n;
+      bytes_read += n;
+      if (n < (off_t) iov[i].iov_len)
+        break;
+    }
+  return bytes_read;
+}
+
+/* Writes the IOV_CNT buffers in IOV, in order, into FILE as one
+   write starting at the file's current position, and advances the
+   position.  Returns the number of bytes actually written. */
+off_t
+file_writev (struct file *file, const struct iovec *iov, int iov_cnt) 
+{
+  off_t bytes_written = inode_writev_at (file->inode, iov, iov_cnt,
+                                         file->pos);
+  file->pos += bytes_written;
+  return bytes_written;
+}
+
+/* Copies up to SIZE bytes from IN, at its current position, to
+   OUT, at its current position, inside the kernel, and advances
+   both positions.  Returns the number of bytes copied. */
+off_t
+file_copy (struct file *in, struct file *out, off_t size) 
+{
+  off_t bytes_copied = inode_copy_at (in->inode, in->pos, out->inode,
+                                      out->pos, size);
+  in->pos += bytes_copied;
+  out->pos += bytes_copied;
+  return bytes_copied;
+}
+
+/* Starts reading up to SIZE bytes of FILE, from its current
+   position, into the buffer cache in the background, so that
+   later reads find them there.  Does not move the position. */
+void
+file_prefetch (struct file *file, off_t size) 
+{
+  inode_prefetch (file->inode, file->pos, size);
+}
+
 /* Prevents write operations on FILE's underlying inode
    until file_allow_write() is called or FILE is closed. */
 void
@@ -1,6 +1,7 @@
 #include "threads/thread.h"
 #include "filesys/filesys.h"
 #include "filesys/cache.h"
+#include "filesys/dentry.h"
 #include <debug.h>
 #include <stdio.h>
 #include <string.h>
@@ -26,6 +27,7 @@ filesys_init (bool format)
   inode_init ();
   free_map_init ();
   cache_init();
+  dentry_init ();
 
 
 
@@ -56,18 +58,31 @@ filesys_done (void)
    or if internal memory allocation fails. */
 bool
 filesys_create (const char *name, off_t initial_size, bool isDir) 
+{
+  return filesys_create_at (NULL, name, initial_size, isDir);
+}
+
+/* Like filesys_create(), but resolves a relative NAME from BASE,
+   or from the current directory if BASE is null. */
+bool
+filesys_create_at (struct dir *base, const char *name, off_t initial_size,
+                   bool isDir) 
 {
   block_sector_t inode_sector = 0;
   //separate path
-  char directory [strlen(name)];
-  char file_name [strlen(name)];
-  separate_path (name, directory, file_name);
-  struct dir *dir = open_dir (directory);
+  char directory [strlen(name) + 1];
+  char file_name [strlen(name) + 1];
+  if (!separate_path (name, directory, file_name))
+    return false;
+  struct dir *dir = open_dir_at (base, directory);
 
 
 
+  // place the new inode near its parent directory's inode
   bool success = (dir != NULL
-                  && free_map_allocate (1, &inode_sector)
+                  && free_map_allocate_near (1,
+                        inode_get_inumber (dir_get_inode (dir)),
+                        &inode_sector)
                   && inode_create (inode_sector, initial_size, isDir)
                   && dir_add (dir, file_name, inode_sector, isDir));
 
@@ -85,14 +100,23 @@ filesys_create (const char *name, off_t initial_size, bool isDir)
    or if an internal memory allocation fails. */
 struct file *
 filesys_open (const char *name)
+{
+  return filesys_open_at (NULL, name);
+}
+
+/* Like filesys_open(), but resolves a relative NAME from BASE,
+   or from the current directory if BASE is null. */
+struct file *
+filesys_open_at (struct dir *base, const char *name)
 {
   int name_len = strlen (name);
   if (name_len == 0) return NULL;
 
   char directory [name_len + 1];
   char file_name [name_len + 1];
-  separate_path (name, directory, file_name);
-  struct dir *dir = open_dir (directory);
+  if (!separate_path (name, directory, file_name))
+    return NULL;
+  struct dir *dir = open_dir_at (base, directory);
   struct inode *inode = NULL;
 
 
@@ -119,11 +143,20 @@ filesys_open (const char *name)
 bool
 filesys_remove (const char *name) 
 {
-  char directory [strlen(name)];
-  char file_name [strlen(name)];
-  separate_path (name, directory, file_name);
+  return filesys_remove_at (NULL, name);
+}
+
+/* Like filesys_remove(), but resolves a relative NAME from BASE,
+   or from the current directory if BASE is null. */
+bool
+filesys_remove_at (struct dir *base, const char *name) 
+{
+  char directory [strlen(name) + 1];
+  char file_name [strlen(name) + 1];
+  if (!separate_path (name, directory, file_name))
+    return false;
 
-  struct dir *dir = open_dir (directory);
+  struct dir *dir = open_dir_at (base, directory);
 
   bool success = (dir != NULL && dir_remove (dir, file_name));
   dir_close (dir); 
@@ -17,4 +17,11 @@ bool filesys_create (const char *name, off_t initial_size, bool);
 struct file *filesys_open (const char *name);
 bool filesys_remove (const char *name);
 
+/* Variants that resolve a relative NAME from directory BASE. */
+struct dir;
+bool filesys_create_at (struct dir *base, const char *name,
+                        off_t initial_size, bool);
+struct file *filesys_open_at (struct dir *base, const char *name);
+bool filesys_remove_at (struct dir *base, const char *name);
+
 #endif /* filesys/filesys.h */
@@ -4,17 +4,22 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "threads/synch.h"
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per sector. */
+static struct lock free_map_lock;    /* Guards FREE_MAP and its file. */
 
 /* Initializes the free map. */
 void
 free_map_init (void) 
 {
+  lock_init (&free_map_lock);
   free_map = bitmap_create (block_size (fs_device));
   if (free_map == NULL)
     PANIC ("bitmap creation failed--file system device is too large");
+  /* Without a summary, allocation just scans more slowly. */
+  bitmap_enable_summary (free_map);
   bitmap_mark (free_map, FREE_MAP_SECTOR);
   bitmap_mark (free_map, ROOT_DIR_SECTOR);
 }
@@ -27,7 +32,26 @@ free_map_init (void)
 bool
 free_map_allocate (size_t cnt, block_sector_t *sectorp)
 {
-  block_sector_t sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
+  return free_map_allocate_near (cnt, 0, sectorp);
+}
+
+/* Like free_map_allocate(), but prefers sectors close to GOAL.
+   The search starts at GOAL and moves toward the end of the
+   device, so successive calls that pass the sector just past the
+   previous allocation get contiguous blocks even while other
+   files are growing.  If nothing fits at or after GOAL, the
+   search wraps around to the start of the device. */
+bool
+free_map_allocate_near (size_t cnt, block_sector_t goal,
+                        block_sector_t *sectorp)
+{
+  block_sector_t sector = BITMAP_ERROR;
+
+  lock_acquire (&free_map_lock);
+  if (goal < bitmap_size (free_map))
+    sector = bitmap_scan_and_flip (free_map, goal, cnt, false);
+  if (sector == BITMAP_ERROR && goal != 0)
+    sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
   if (sector != BITMAP_ERROR
       && free_map_file != NULL
       && !bitmap_write (free_map, free_map_file))
@@ -35,18 +59,83 @@ free_map_allocate (size_t cnt, block_sector_t *sectorp)
       bitmap_set_multiple (free_map, sector, cnt, false); 
       sector = BITMAP_ERROR;
     }
+  lock_release (&free_map_lock);
   if (sector != BITMAP_ERROR)
     *sectorp = sector;
   return sector != BITMAP_ERROR;
 }
 
+/* Allocates up to CNT sectors from the free map as at most
+   MAX_RUNS runs of consecutive sectors, stored into RUNS.
+   Uses a next-fit policy: the runs are the free extents found
+   at or after GOAL, in disk order, wrapping around to the start
+   of the device, and each run is as long as the free extent
+   allows.  Returns the number of runs stored, which cover fewer
+   than CNT sectors if the device is too full or fragmented, or 0
+   if nothing could be allocated or the free_map file could not be
+   written. */
+size_t
+free_map_allocate_runs (size_t cnt, block_sector_t goal,
+                        struct free_map_run runs[], size_t max_runs)
+{
+  size_t size = bitmap_size (free_map);
+  size_t pos = goal < size ? goal : 0;
+  bool wrapped = pos == 0;
+  size_t run_cnt = 0;
+
+  lock_acquire (&free_map_lock);
+  while (cnt > 0 && run_cnt < max_runs)
+    {
+      size_t start = bitmap_scan (free_map, pos, 1, false);
+      size_t len;
+
+      if (start == BITMAP_ERROR)
+        {
+          if (wrapped)
+            break;
+          wrapped = true;
+          pos = 0;
+          continue;
+        }
+
+      /* Extend the run up to the next sector in use. */
+      len = cnt < size - start ? cnt : size - start;
+      if (bitmap_contains (free_map, start, len, true))
+        len = bitmap_scan (free_map, start, 1, true) - start;
+      bitmap_set_multiple (free_map, start, len, true);
+
+      runs[run_cnt].start = start;
+      runs[run_cnt].cnt = len;
+      run_cnt++;
+      cnt -= len;
+      pos = start + len;
+    }
+
+  if (run_cnt > 0
+      && free_map_file != NULL
+      && !bitmap_write (free_map, free_map_file))
+    {
+      while (run_cnt > 0)
+        {
+          run_cnt--;
+          bitmap_set_multiple (free_map, runs[run_cnt].start,
+                               runs[run_cnt].cnt, false);
+        }
+    }
+  lock_release (&free_map_lock);
+  return run_cnt;
+}
+
 /* Makes CNT sectors starting at SECTOR available for use. */
 void
 free_map_release (block_sector_t sector, size_t cnt)
 {
+  lock_acquire (&free_map_lock);
   ASSERT (bitmap_all (free_map, sector, cnt));
   bitmap_set_multiple (free_map, sector, cnt, false);
-  bitmap_write (free_map, free_map_file);
+  if (free_map_file != NULL)
+    bitmap_write (free_map, free_map_file);
+  lock_release (&free_map_lock);
 }
 
 /* Opens the free map file and reads it from disk. */
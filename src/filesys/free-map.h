@@ -11,7 +11,17 @@ void free_map_create (void);
 void free_map_open (void);
 void free_map_close (void);
 
+/* A run of consecutive sectors. */
+struct free_map_run
+  {
+    block_sector_t start;       /* First sector. */
+    size_t cnt;                 /* Number of sectors. */
+  };
+
 bool free_map_allocate (size_t, block_sector_t *);
+bool free_map_allocate_near (size_t, block_sector_t goal, block_sector_t *);
+size_t free_map_allocate_runs (size_t, block_sector_t goal,
+                               struct free_map_run[], size_t max_runs);
 void free_map_release (block_sector_t, size_t);
 
 #endif /* filesys/free-map.h */
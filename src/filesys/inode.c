@@ -3,6 +3,7 @@
 #include <debug.h>
 #include <round.h>
 #include <string.h>
+#include <uio.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
@@ -14,6 +15,11 @@
 #define INODE_NUM_DIRECT_BLOCKS 123
 #define DIRECT_BLOCKS_PER_SECTOR 128
 
+/* Most data sectors one inode can index. */
+#define INODE_MAX_SECTORS (INODE_NUM_DIRECT_BLOCKS \
+                           + DIRECT_BLOCKS_PER_SECTOR \
+                           + DIRECT_BLOCKS_PER_SECTOR * DIRECT_BLOCKS_PER_SECTOR)
+
 
 /* On-disk inode.
    Must be exactly BLOCK_SECTOR_SIZE bytes long. */
@@ -51,16 +57,53 @@ struct inode
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
     struct inode_disk data;             /* Inode content. */
 
-    struct lock inode_lock;             // Prevents multiple threads extending a file.
+    struct lock inode_lock;             // Guards deny_write_cnt, removed, readable_length, extensions.
     off_t readable_length;              // Prevents readers from reading unwritten zeroes.
+    struct list extensions;             // Extending writes in progress, in file order.
+    struct rwlock data_rw;              // Shared by reads and writes, exclusive to grow the file.
+    struct rwlock dir_rw;               // Shared by directory lookups, exclusive for changes.
+  };
+
+/* A write in progress that extends its inode.  Extensions take
+   turns growing the file, so each starts where the one before it
+   ends, and readers may not read past the start of the first one
+   still being written. */
+struct extension
+  {
+    off_t start;                        /* Length before extending, or -1. */
+    struct list_elem elem;              /* Element in inode's extensions. */
   };
 
 static block_sector_t index_to_sector(const struct inode*, off_t);
-static bool inode_alloc(struct inode_disk*, size_t);
-static bool inode_alloc_indirect(block_sector_t*, size_t, int);
+/* Sectors reserved from the free map for one inode_alloc() call.
+   Extending a file reserves everything it needs in a few runs up
+   front instead of scanning the free map once per sector. */
+#define RESERVE_MAX_RUNS 8
+struct block_reserve
+  {
+    struct free_map_run runs[RESERVE_MAX_RUNS];
+    size_t run_cnt;                     /* Number of runs in RUNS. */
+    size_t run_idx;                     /* Run being handed out. */
+    size_t run_used;                    /* Sectors handed out of it. */
+    size_t want;                        /* Sectors still needed, at most. */
+    block_sector_t goal;                /* Where the next sector should go. */
+  };
+
+static bool inode_alloc(struct inode_disk*, size_t, block_sector_t);
+static bool inode_alloc_blocks(struct inode_disk*, size_t,
+                                struct block_reserve*);
+static bool inode_alloc_indirect(block_sector_t*, size_t, int,
+                                  struct block_reserve*);
+static bool inode_alloc_sector(block_sector_t*, struct block_reserve*);
 static bool inode_free(struct inode*);
 static bool inode_free_indirect(block_sector_t, size_t, int);
 static uint32_t min(uint32_t x, uint32_t y);
+static off_t write_chunks(struct inode *, const void *, off_t, off_t);
+static bool begin_write(struct inode *, off_t, off_t, struct extension *);
+static void advance_readable(struct inode *, struct extension *);
+
+/* Bytes moved at a time by inode_copy_at(). */
+#define COPY_CHUNK (8 * BLOCK_SECTOR_SIZE)
 
 
 /* Returns the block device sector that contains byte offset POS
@@ -133,11 +176,15 @@ static block_sector_t index_to_sector (const struct inode *inode,
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Guards OPEN_INODES and each inode's open_cnt. */
+static struct lock open_inodes_lock;
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   list_init (&open_inodes);
+  lock_init (&open_inodes_lock);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -160,11 +207,10 @@ inode_create (block_sector_t sector, off_t length, bool isDir)
   disk_inode = calloc (1, sizeof *disk_inode);
   if (disk_inode != NULL)
     {
-      size_t sectors = bytes_to_sectors (length);
-      disk_inode->length = length;
       disk_inode->magic = INODE_MAGIC;
       disk_inode->isDir = isDir;
-      if (inode_alloc(disk_inode, disk_inode->length)) {
+      if (inode_alloc(disk_inode, length, sector + 1)) {
+        disk_inode->length = length;
         cache_write(sector, disk_inode);
         success = true; 
       }
@@ -183,13 +229,15 @@ inode_open (block_sector_t sector)
   struct inode *inode;
 
   /* Check whether this inode is already open. */
+  lock_acquire (&open_inodes_lock);
   for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
        e = list_next (e)) 
     {
       inode = list_entry (e, struct inode, elem);
       if (inode->sector == sector) 
         {
-          inode_reopen (inode);
+          inode->open_cnt++;
+          lock_release (&open_inodes_lock);
           return inode; 
         }
     }
@@ -197,6 +245,7 @@ inode_open (block_sector_t sector)
   /* Allocate memory. */
   inode = malloc (sizeof *inode);
   if (inode == NULL) {
+   lock_release (&open_inodes_lock);
    return NULL;
   }
 
@@ -207,8 +256,12 @@ inode_open (block_sector_t sector)
   inode->deny_write_cnt = 0;
   inode->removed = false;
   lock_init(&inode->inode_lock);
+  rw_init(&inode->data_rw);
+  rw_init(&inode->dir_rw);
+  list_init(&inode->extensions);
   cache_read (inode->sector, &inode->data);
   inode->readable_length = inode_length(inode);
+  lock_release (&open_inodes_lock);
   return inode;
 }
 
@@ -217,7 +270,11 @@ struct inode *
 inode_reopen (struct inode *inode)
 {
   if (inode != NULL)
-    inode->open_cnt++;
+    {
+      lock_acquire (&open_inodes_lock);
+      inode->open_cnt++;
+      lock_release (&open_inodes_lock);
+    }
   return inode;
 }
 
@@ -239,22 +296,27 @@ inode_close (struct inode *inode)
     return;
 
   /* Release resources if this was the last opener. */
-  if (--inode->open_cnt == 0)
+  lock_acquire (&open_inodes_lock);
+  if (--inode->open_cnt > 0)
     {
-      /* Remove from inode list and release lock. */
-      list_remove (&inode->elem);
- 
-      /* Deallocate blocks if removed. */
-      if (inode->removed) 
-        {
-          free_map_release (inode->sector, 1);
-          inode_free(inode);
-          /*free_map_release (inode->data.start,
-                            bytes_to_sectors (inode->data.length));*/ 
-        }
+      lock_release (&open_inodes_lock);
+      return;
+    }
 
-      free (inode); 
+  /* Remove from inode list and release lock. */
+  list_remove (&inode->elem);
+  lock_release (&open_inodes_lock);
+ 
+  /* Deallocate blocks if removed. */
+  if (inode->removed) 
+    {
+      free_map_release (inode->sector, 1);
+      inode_free(inode);
+      /*free_map_release (inode->data.start,
+                        bytes_to_sectors (inode->data.length));*/ 
     }
+
+  free (inode); 
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -263,7 +325,9 @@ void
 inode_remove (struct inode *inode) 
 {
   ASSERT (inode != NULL);
+  lock_acquire (&inode->inode_lock);
   inode->removed = true;
+  lock_release (&inode->inode_lock);
 }
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
@@ -276,7 +340,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
   off_t bytes_read = 0;
   uint8_t *bounce = NULL;
 
-
+  rw_read_acquire (&inode->data_rw);
   while (size > 0) 
     {
       /* Disk sector to read, starting byte offset within sector. */
@@ -315,35 +379,211 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
         cache_read_ahead(sector_idx);
       }
     }
+    rw_read_release (&inode->data_rw);
 
     return bytes_read;
 }
 
+/* Starts reading the sectors that hold the SIZE bytes of INODE at
+   OFFSET, up to end of file, into the buffer cache in the
+   background.  Does nothing if memory runs out. */
+void
+inode_prefetch (struct inode *inode, off_t offset, off_t size)
+{
+  block_sector_t *sectors;
+  size_t cnt = 0;
+  off_t pos, end;
+
+  rw_read_acquire (&inode->data_rw);
+  end = offset + size < inode->data.length ? offset + size
+                                           : inode->data.length;
+  pos = ROUND_DOWN (offset, BLOCK_SECTOR_SIZE);
+  sectors = pos < end ? malloc (DIV_ROUND_UP (end - pos, BLOCK_SECTOR_SIZE)
+                                * sizeof *sectors)
+                      : NULL;
+  if (sectors != NULL)
+    for (; pos < end; pos += BLOCK_SECTOR_SIZE)
+      sectors[cnt++] = byte_to_sector (inode, pos);
+  rw_read_release (&inode->data_rw);
+
+  cache_prefetch (sectors, cnt);
+  free (sectors);
+}
+
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
    Returns the number of bytes actually written, which may be
    less than SIZE if end of file is reached or an error occurs.
    (Normally a write at end of file would extend the inode, but
    growth is not yet implemented.) */
 off_t
-inode_write_at (struct inode *inode, const void *buffer_, off_t size,
+inode_write_at (struct inode *inode, const void *buffer, off_t size,
                 off_t offset) 
 {
-  const uint8_t *buffer = buffer_;
+  struct iovec iov;
+
+  iov.iov_base = (void *) buffer;
+  iov.iov_len = size;
+  return inode_writev_at (inode, &iov, 1, offset);
+}
+
+/* Writes the IOV_CNT buffers in IOV into INODE one after another,
+   starting at OFFSET.  The file is extended at most once, to the
+   end of the last buffer.  Returns the number of bytes actually
+   written, which may be less than the total if an error occurs. */
+off_t
+inode_writev_at (struct inode *inode, const struct iovec *iov, int iov_cnt,
+                 off_t offset) 
+{
+  struct extension ext;
+  off_t size = 0;
   off_t bytes_written = 0;
-  if (inode->deny_write_cnt)
+  int i;
+
+  for (i = 0; i < iov_cnt; i++)
+    size += iov[i].iov_len;
+
+  if (!begin_write(inode, offset, size, &ext))
     return 0;
-  if (byte_to_sector(inode, offset + size - 1) == -1) {
-    lock_acquire(&inode->inode_lock);
-    if (!inode_alloc(&inode->data, offset+size)) {
-      // Error: could not extend file
+  for (i = 0; i < iov_cnt; i++) {
+    off_t seg_written = write_chunks (inode, iov[i].iov_base,
+                                      iov[i].iov_len, offset);
+    offset += seg_written;
+    bytes_written += seg_written;
+    if (seg_written < (off_t) iov[i].iov_len)
+      break;
+  }
+  rw_read_release(&inode->data_rw);
+  advance_readable(inode, &ext);
+  return bytes_written;
+}
+
+/* Copies up to SIZE bytes from SRC, starting at SRC_OFS, into DST,
+   starting at DST_OFS, without the data leaving the kernel.  DST's
+   blocks are all allocated before copying starts.  Returns the
+   number of bytes copied, which is less than SIZE if SRC ends
+   first or an error occurs. */
+off_t
+inode_copy_at (struct inode *src, off_t src_ofs, struct inode *dst,
+               off_t dst_ofs, off_t size)
+{
+  struct extension ext;
+  uint8_t *bounce;
+  off_t copied = 0;
+
+  if (size > inode_length(src) - src_ofs)
+    size = inode_length(src) - src_ofs;
+  if (size <= 0)
+    return 0;
+  bounce = malloc(COPY_CHUNK);
+  if (bounce == NULL)
+    return 0;
+
+  // Grow DST once, then let go of it while reading SRC, which may
+  // be the same inode.  Files never shrink, so the blocks stay.
+  if (!begin_write(dst, dst_ofs, size, &ext)) {
+    free(bounce);
+    return 0;
+  }
+  rw_read_release(&dst->data_rw);
+  while (copied < size) {
+    // Keep chunks aligned to DST's sectors so that whole sectors
+    // are written without being read first.
+    off_t chunk = COPY_CHUNK - (dst_ofs + copied) % BLOCK_SECTOR_SIZE;
+    off_t n, written;
+
+    if (chunk > size - copied)
+      chunk = size - copied;
+    n = inode_read_at(src, bounce, chunk, src_ofs + copied);
+    if (n <= 0)
+      break;
+    rw_read_acquire(&dst->data_rw);
+    written = write_chunks(dst, bounce, n, dst_ofs + copied);
+    rw_read_release(&dst->data_rw);
+    copied += written;
+    if (written < n)
+      break;
+  }
+  advance_readable(dst, &ext);
+  free(bounce);
+  return copied;
+}
+
+/* Prepares to write SIZE bytes to INODE at OFFSET.  Extends the
+   file first if the write ends past its last block, and records
+   the extension in *EXT, which the caller passes to
+   advance_readable() once the write is done.  Returns true with
+   INODE's data lock held for reading, or false with no lock held
+   if writes are denied or the file cannot be extended. */
+static bool
+begin_write (struct inode *inode, off_t offset, off_t size,
+             struct extension *ext)
+{
+  ext->start = -1;
+  lock_acquire(&inode->inode_lock);
+  if (inode->deny_write_cnt) {
+    lock_release(&inode->inode_lock);
+    return false;
+  }
+  lock_release(&inode->inode_lock);
+
+  // Writes within the file share the inode with readers and other
+  // writers.  Growing it changes the block map, so takes it alone.
+  rw_read_acquire(&inode->data_rw);
+  if (size > 0 && byte_to_sector(inode, offset + size - 1) == -1) {
+    if (!rw_upgrade(&inode->data_rw)) {
+      rw_read_release(&inode->data_rw);
+      rw_write_acquire(&inode->data_rw);
+    }
+    // Recheck: another writer may have extended the file past
+    // this write already, and must not be undone.
+    if (byte_to_sector(inode, offset + size - 1) == -1) {
+      if (!inode_alloc(&inode->data, offset+size, inode->sector + 1)) {
+        // Error: could not extend file
+        rw_write_release(&inode->data_rw);
+        return false;
+      }
+      // Keep readers short of the new bytes until they are written.
+      lock_acquire(&inode->inode_lock);
+      ext->start = inode->data.length;
+      list_push_back(&inode->extensions, &ext->elem);
       lock_release(&inode->inode_lock);
-      return 0;
+      inode->data.length = offset + size;
+      cache_write(inode->sector, &inode->data);
     }
-    inode->data.length = offset + size;
-    lock_release(&inode->inode_lock);
-    cache_write(inode->sector, &inode->data);
-    inode->readable_length = inode->data.length;
+    rw_downgrade(&inode->data_rw);
   }
+  return true;
+}
+
+/* Ends the write that begin_write() started with EXT.  If it
+   extended INODE, lets readers see as far as the start of the
+   first extension still being written, or the whole file if there
+   is none. */
+static void
+advance_readable (struct inode *inode, struct extension *ext)
+{
+  if (ext->start < 0)
+    return;
+  lock_acquire(&inode->inode_lock);
+  list_remove(&ext->elem);
+  if (list_empty(&inode->extensions))
+    inode->readable_length = inode_length(inode);
+  else
+    inode->readable_length = list_entry(list_front(&inode->extensions),
+                                        struct extension, elem)->start;
+  lock_release(&inode->inode_lock);
+}
+
+/* Writes SIZE bytes from BUFFER_ into INODE's existing blocks,
+   starting at OFFSET.  The caller holds INODE's data lock.
+   Returns the number of bytes written. */
+static off_t
+write_chunks (struct inode *inode, const void *buffer_, off_t size,
+              off_t offset)
+{
+  const uint8_t *buffer = buffer_;
+  off_t bytes_written = 0;
+
   while (size > 0) 
     {
       /* Sector to write, starting byte offset within sector. */
@@ -384,8 +624,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 void
 inode_deny_write (struct inode *inode) 
 {
+  lock_acquire (&inode->inode_lock);
   inode->deny_write_cnt++;
   ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+  lock_release (&inode->inode_lock);
 }
 
 /* Re-enables writes to INODE.
@@ -394,9 +636,11 @@ inode_deny_write (struct inode *inode)
 void
 inode_allow_write (struct inode *inode) 
 {
+  lock_acquire (&inode->inode_lock);
   ASSERT (inode->deny_write_cnt > 0);
   ASSERT (inode->deny_write_cnt <= inode->open_cnt);
   inode->deny_write_cnt--;
+  lock_release (&inode->inode_lock);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
@@ -406,22 +650,58 @@ inode_length (const struct inode *inode)
   return inode->data.length;
 }
 
-static bool inode_alloc(struct inode_disk* disk_inode, size_t size) {
-  if (size < 0) {
+// Allocates every block needed to grow DISK_INODE from its current
+// length to SIZE bytes.  New blocks are placed as close as possible
+// after the file's last existing block, starting from GOAL (normally
+// the sector just past the inode itself) for an empty file.  Fails,
+// reserving nothing, if SIZE is more than an inode can index.
+static bool inode_alloc(struct inode_disk* disk_inode, size_t size,
+                          block_sector_t goal) {
+  if (bytes_to_sectors(size) > INODE_MAX_SECTORS) {
     return false;
   }
-  static char zeros[BLOCK_SECTOR_SIZE];
 
+  // Files have no holes, so every data block past the current
+  // length is new.  Also count the index blocks they might need.
+  size_t old_sectors = bytes_to_sectors(disk_inode->length);
+  size_t new_sectors = bytes_to_sectors(size);
+  struct block_reserve reserve;
+  reserve.run_cnt = reserve.run_idx = reserve.run_used = 0;
+  reserve.want = 0;
+  if (new_sectors > old_sectors) {
+    reserve.want = new_sectors - old_sectors
+                   + DIV_ROUND_UP(new_sectors - old_sectors,
+                                  DIRECT_BLOCKS_PER_SECTOR) + 2;
+  }
+  reserve.goal = goal;
+
+  bool success = inode_alloc_blocks(disk_inode, size, &reserve);
+
+  // Give back whatever was reserved but not used.
+  for (; reserve.run_idx < reserve.run_cnt; reserve.run_idx++) {
+    struct free_map_run *run = &reserve.runs[reserve.run_idx];
+    if (run->cnt > reserve.run_used) {
+      free_map_release(run->start + reserve.run_used,
+                        run->cnt - reserve.run_used);
+    }
+    reserve.run_used = 0;
+  }
+  return success;
+}
+
+static bool inode_alloc_blocks(struct inode_disk* disk_inode, size_t size,
+                                struct block_reserve *reserve) {
   size_t sectors_to_alloc = bytes_to_sectors(size);
 
   size_t index;
   size_t max_index = min(sectors_to_alloc, INODE_NUM_DIRECT_BLOCKS); 
   for (index = 0; index < max_index; index++) {
     if (!disk_inode->direct_blocks[index]) {
-      if (!free_map_allocate(1, &disk_inode->direct_blocks[index])) {
+      if (!inode_alloc_sector(&disk_inode->direct_blocks[index], reserve)) {
         return false;
       }
-      cache_write(disk_inode->direct_blocks[index], zeros);
+    } else {
+      reserve->goal = disk_inode->direct_blocks[index] + 1;
     }
     sectors_to_alloc--;
   }
@@ -431,7 +711,8 @@ static bool inode_alloc(struct inode_disk* disk_inode, size_t size) {
   }
 
   max_index = min(sectors_to_alloc, DIRECT_BLOCKS_PER_SECTOR);
-  if (!inode_alloc_indirect(&disk_inode->single_indirect_block, max_index, 1)) {
+  if (!inode_alloc_indirect(&disk_inode->single_indirect_block, max_index, 1,
+                                reserve)) {
     return false;
   }
   sectors_to_alloc -= max_index;
@@ -443,7 +724,7 @@ static bool inode_alloc(struct inode_disk* disk_inode, size_t size) {
   size_t double_indirect_sectors = DIRECT_BLOCKS_PER_SECTOR * DIRECT_BLOCKS_PER_SECTOR;
   max_index = min(sectors_to_alloc, double_indirect_sectors);
   if (!inode_alloc_indirect(&disk_inode->double_indirect_block,
-                                max_index, 2)) {
+                                max_index, 2, reserve)) {
     return false;
   }
   sectors_to_alloc -= max_index;
@@ -456,27 +737,22 @@ static bool inode_alloc(struct inode_disk* disk_inode, size_t size) {
 }
 
 static bool inode_alloc_indirect(block_sector_t *block, size_t sectors_to_alloc,
-                                      int level) {
-  static char zeros[BLOCK_SECTOR_SIZE];
-
+                                      int level, struct block_reserve *reserve) {
   // Allocate direct blocks
   if (level == 0) {
     if (!*block) {
-      if (!free_map_allocate(1, block)) {
-        return false;
-      }
-      cache_write(*block, zeros);
+      return inode_alloc_sector(block, reserve);
     }
+    reserve->goal = *block + 1;
     return true;
   }
 
   // Begin allocating indirect block recursively
   struct indirect_block indirectBlock;
   if (!*block) {
-    if (!free_map_allocate(1, block)) {
+    if (!inode_alloc_sector(block, reserve)) {
       return false;
     }
-    cache_write(*block, zeros);
   }
   cache_read(*block, &indirectBlock);
 
@@ -496,7 +772,7 @@ static bool inode_alloc_indirect(block_sector_t *block, size_t sectors_to_alloc,
       chunk_to_alloc = min(sectors_to_alloc, DIRECT_BLOCKS_PER_SECTOR);
     }
     if (!inode_alloc_indirect(&indirectBlock.direct_blocks[index],
-                                  chunk_to_alloc, level - 1)) {
+                                  chunk_to_alloc, level - 1, reserve)) {
       return false;
     }
     sectors_to_alloc -= chunk_to_alloc;
@@ -505,6 +781,38 @@ static bool inode_alloc_indirect(block_sector_t *block, size_t sectors_to_alloc,
   return true;
 }
 
+// Hands out the next zeroed sector from RESERVE into *SECTORP.  When
+// the reserve runs dry, refills it from the free map with runs
+// starting as near as possible to the reserve's goal, which follows
+// the file's last block so its blocks stay contiguous.
+static bool inode_alloc_sector(block_sector_t *sectorp,
+                                struct block_reserve *reserve) {
+  static char zeros[BLOCK_SECTOR_SIZE];
+
+  if (reserve->run_idx == reserve->run_cnt) {
+    size_t cnt = reserve->want > 0 ? reserve->want : 1;
+    reserve->run_cnt = free_map_allocate_runs(cnt, reserve->goal,
+                                              reserve->runs, RESERVE_MAX_RUNS);
+    reserve->run_idx = reserve->run_used = 0;
+    if (reserve->run_cnt == 0) {
+      return false;
+    }
+  }
+
+  struct free_map_run *run = &reserve->runs[reserve->run_idx];
+  *sectorp = run->start + reserve->run_used;
+  if (++reserve->run_used == run->cnt) {
+    reserve->run_idx++;
+    reserve->run_used = 0;
+  }
+  if (reserve->want > 0) {
+    reserve->want--;
+  }
+  cache_write(*sectorp, zeros);
+  reserve->goal = *sectorp + 1;
+  return true;
+}
+
 static bool inode_free(struct inode *inode) {
   // Nothing to deallocate
   if (!inode->data.length) {
@@ -579,3 +887,23 @@ bool inode_is_removed(struct inode *inode) {
 bool inode_is_dir(struct inode *inode) {
   return inode->data.isDir;
 }
+
+// Locks directory INODE's entries: shared, so that other threads
+// may look them up but not change them, or EXCLUSIVE, to change
+// them.
+void inode_lock_dir(struct inode *inode, bool exclusive) {
+  if (exclusive) {
+    rw_write_acquire(&inode->dir_rw);
+  } else {
+    rw_read_acquire(&inode->dir_rw);
+  }
+}
+
+// Releases the lock taken by inode_lock_dir().
+void inode_unlock_dir(struct inode *inode) {
+  if (rw_write_held_by_current_thread(&inode->dir_rw)) {
+    rw_write_release(&inode->dir_rw);
+  } else {
+    rw_read_release(&inode->dir_rw);
+  }
+}
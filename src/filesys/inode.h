@@ -6,6 +6,7 @@
 #include "devices/block.h"
 
 struct bitmap;
+struct iovec;
 
 void inode_init (void);
 bool inode_create (block_sector_t, off_t, bool);
@@ -16,10 +17,17 @@ void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_writev_at (struct inode *, const struct iovec *, int iov_cnt,
+                       off_t offset);
+off_t inode_copy_at (struct inode *src, off_t src_ofs, struct inode *dst,
+                     off_t dst_ofs, off_t size);
+void inode_prefetch (struct inode *, off_t offset, off_t size);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
 bool inode_is_removed(struct inode *);
 bool inode_is_dir(struct inode *);
+void inode_lock_dir(struct inode *, bool exclusive);
+void inode_unlock_dir(struct inode *);
 
 #endif /* filesys/inode.h */
@@ -28,8 +28,24 @@ struct bitmap
   {
     size_t bit_cnt;     /* Number of bits. */
     elem_type *bits;    /* Elements that represent bits. */
+    struct bitmap *summary; /* One bit per element, true if full. */
   };
 
+/* Optional summary layer.
+
+   A bitmap may carry a summary bitmap, built by
+   bitmap_enable_summary(), with one bit per element of BITS.  A
+   summary bit is true if and only if every bit in the
+   corresponding element is true.  Searching for a false bit can
+   then skip ELEM_BITS full elements per summary element examined.
+   The summary is itself summarized until it fits in a single
+   element, so finding a free bit in a nearly full bitmap costs
+   O(log n) rather than O(n).
+
+   Bits are still set atomically, but the summary is updated
+   afterward as a separate step, so a bitmap with a summary must
+   be protected by an external lock if it is shared. */
+
 /* Returns the index of the element that contains the bit
    numbered BIT_IDX. */
 static inline size_t
@@ -69,6 +85,38 @@ last_mask (const struct bitmap *b)
   return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
 
+/* Returns the index of the lowest set bit in WORD, which must be
+   nonzero. */
+static inline size_t
+first_set_bit (elem_type word)
+{
+  ASSERT (word != 0);
+  return __builtin_ctzl (word);
+}
+
+/* Returns true if every bit of element IDX in B that lies within
+   the bitmap is set to true. */
+static inline bool
+elem_full (const struct bitmap *b, size_t idx)
+{
+  elem_type mask = idx == elem_cnt (b->bit_cnt) - 1 ? last_mask (b)
+                                                    : (elem_type) -1;
+  return (b->bits[idx] & mask) == mask;
+}
+
+/* Brings the summary bit for element IDX in B, if B has a
+   summary, up to date with the element's contents. */
+static inline void
+update_summary (struct bitmap *b, size_t idx)
+{
+  if (b->summary != NULL)
+    {
+      bool full = elem_full (b, idx);
+      if (bitmap_test (b->summary, idx) != full)
+        bitmap_set (b->summary, idx, full);
+    }
+}
+
 /* Creation and destruction. */
 
 /* Creates and returns a pointer to a newly allocated bitmap with room for
@@ -83,6 +131,7 @@ bitmap_create (size_t bit_cnt)
     {
       b->bit_cnt = bit_cnt;
       b->bits = malloc (byte_cnt (bit_cnt));
+      b->summary = NULL;
       if (b->bits != NULL || bit_cnt == 0)
         {
           bitmap_set_all (b, false);
@@ -105,6 +154,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
 
   b->bit_cnt = bit_cnt;
   b->bits = (elem_type *) (b + 1);
+  b->summary = NULL;
   bitmap_set_all (b, false);
   return b;
 }
@@ -124,10 +174,42 @@ bitmap_destroy (struct bitmap *b)
 {
   if (b != NULL) 
     {
+      bitmap_destroy (b->summary);
       free (b->bits);
       free (b);
     }
 }
+
+/* Adds a summary layer to B (see the comment on struct bitmap),
+   which speeds up searches for false bits in large, mostly true
+   bitmaps.  Returns true if successful, false if memory
+   allocation fails, in which case B still works, only without
+   the speedup.
+   Not for use on bitmaps created by bitmap_create_in_buf(). */
+bool
+bitmap_enable_summary (struct bitmap *b) 
+{
+  size_t i;
+
+  ASSERT (b != NULL);
+
+  if (b->summary != NULL || b->bit_cnt <= ELEM_BITS)
+    return true;
+
+  b->summary = bitmap_create (elem_cnt (b->bit_cnt));
+  if (b->summary == NULL)
+    return false;
+  for (i = 0; i < elem_cnt (b->bit_cnt); i++)
+    if (elem_full (b, i))
+      bitmap_mark (b->summary, i);
+  if (!bitmap_enable_summary (b->summary))
+    {
+      bitmap_destroy (b->summary);
+      b->summary = NULL;
+      return false;
+    }
+  return true;
+}
 
 /* Bitmap size. */
 
@@ -163,6 +245,7 @@ bitmap_mark (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the OR instruction in [IA32-v2b]. */
   asm ("orl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  update_summary (b, idx);
 }
 
 /* Atomically sets the bit numbered BIT_IDX in B to false. */
@@ -176,6 +259,7 @@ bitmap_reset (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the AND instruction in [IA32-v2a]. */
   asm ("andl %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+  update_summary (b, idx);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -191,6 +275,7 @@ bitmap_flip (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the XOR instruction in [IA32-v2b]. */
   asm ("xorl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  update_summary (b, idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -245,21 +330,51 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
   return value_cnt;
 }
 
+/* Returns the index of the first bit in B between START and END,
+   exclusive, that is set to VALUE, or END if there is none.
+   Examines a whole element at a time, and when looking for a
+   false bit uses B's summary, if any, to skip full elements. */
+static size_t
+find_bit (const struct bitmap *b, size_t start, size_t end, bool value) 
+{
+  elem_type flip = value ? 0 : (elem_type) -1;
+  size_t idx, last_idx, bit;
+  elem_type word;
+
+  if (start >= end)
+    return end;
+
+  /* Bits below START in its element don't count. */
+  idx = elem_idx (start);
+  last_idx = elem_idx (end - 1);
+  word = (b->bits[idx] ^ flip) & ~(bit_mask (start) - 1);
+  while (word == 0)
+    {
+      if (++idx > last_idx)
+        return end;
+      if (!value && b->summary != NULL)
+        {
+          idx = find_bit (b->summary, idx, last_idx + 1, false);
+          if (idx > last_idx)
+            return end;
+        }
+      word = b->bits[idx] ^ flip;
+    }
+
+  bit = idx * ELEM_BITS + first_set_bit (word);
+  return bit < end ? bit : end;
+}
+
 /* Returns true if any bits in B between START and START + CNT,
    exclusive, are set to VALUE, and false otherwise. */
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
-  
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
-  return false;
+  return find_bit (b, start, start + cnt, value) != start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -298,13 +413,27 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
 
+  if (cnt == 0)
+    return start;
   if (cnt <= b->bit_cnt) 
     {
       size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
+      size_t i = start;
+      while (i <= last)
+        {
+          /* Jump to the next candidate, then look for a bit that
+             cuts the group short.  The group can't start at or
+             before that bit, so resume just past it. */
+          size_t stop;
+
+          i = find_bit (b, i, b->bit_cnt, value);
+          if (i > last)
+            break;
+          stop = find_bit (b, i, i + cnt, !value);
+          if (stop == i + cnt)
+            return i;
+          i = stop + 1;
+        }
     }
   return BITMAP_ERROR;
 }
@@ -346,6 +475,12 @@ bitmap_read (struct bitmap *b, struct file *file)
       off_t size = byte_cnt (b->bit_cnt);
       success = file_read_at (file, b->bits, size, 0) == size;
       b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+      if (b->summary != NULL)
+        {
+          size_t i;
+          for (i = 0; i < elem_cnt (b->bit_cnt); i++)
+            update_summary (b, i);
+        }
     }
   return success;
 }
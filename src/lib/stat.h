@@ -0,0 +1,15 @@
+#ifndef __LIB_STAT_H
+#define __LIB_STAT_H
+
+#include <stdbool.h>
+
+/* A file's metadata, as filled in by the stat and fstat system
+   calls. */
+struct stat
+  {
+    int st_ino;                         /* Inode number. */
+    int st_size;                        /* Length in bytes. */
+    bool st_isdir;                      /* Is it a directory? */
+  };
+
+#endif /* lib/stat.h */
@@ -28,7 +28,20 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+    SYS_GETDENTS,               /* Reads many directory entries. */
+    SYS_STAT,                   /* Obtains a named file's metadata. */
+    SYS_FSTAT,                  /* Obtains an open file's metadata. */
+    SYS_OPENAT,                 /* Open a file relative to a directory. */
+    SYS_CREATEAT,               /* Create a file relative to a directory. */
+    SYS_MKDIRAT,                /* Create a directory relative to one. */
+    SYS_UNLINKAT,               /* Delete a file relative to a directory. */
+    SYS_PREAD,                  /* Read from a file at a given offset. */
+    SYS_PWRITE,                 /* Write to a file at a given offset. */
+    SYS_READV,                  /* Read from a file into many buffers. */
+    SYS_WRITEV,                 /* Write many buffers to a file. */
+    SYS_COPY_FILE_RANGE,        /* Copy between files in the kernel. */
+    SYS_FORK                    /* Duplicate the calling process. */
   };
 
 #endif /* lib/syscall-nr.h */
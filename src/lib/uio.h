@@ -0,0 +1,17 @@
+#ifndef __LIB_UIO_H
+#define __LIB_UIO_H
+
+#include <stddef.h>
+
+/* Maximum number of buffers in one readv or writev call. */
+#define IOV_MAX 64
+
+/* One buffer in a scatter/gather list, as used by readv and
+   writev. */
+struct iovec
+  {
+    void *iov_base;                     /* Start of buffer. */
+    size_t iov_len;                     /* Length in bytes. */
+  };
+
+#endif /* lib/uio.h */
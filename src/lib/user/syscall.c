@@ -61,6 +61,25 @@
           retval;                                               \
         })
 
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+   and ARG3, and returns the return value as an `int'. */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg3]; pushl %[arg2]; pushl %[arg1]; "    \
+             "pushl %[arg0]; pushl %[number]; int $0x30; "      \
+             "addl $20, %%esp"                                  \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "r" (ARG0),                             \
+                 [arg1] "r" (ARG1),                             \
+                 [arg2] "r" (ARG2),                             \
+                 [arg3] "r" (ARG3)                              \
+               : "memory");                                     \
+          retval;                                               \
+        })
+
 void
 halt (void) 
 {
@@ -182,3 +201,81 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+int
+getdents (int fd, struct dirent *ents, unsigned cnt) 
+{
+  return syscall3 (SYS_GETDENTS, fd, ents, cnt);
+}
+
+bool
+stat (const char *file, struct stat *st) 
+{
+  return syscall2 (SYS_STAT, file, st);
+}
+
+bool
+fstat (int fd, struct stat *st) 
+{
+  return syscall2 (SYS_FSTAT, fd, st);
+}
+
+int
+openat (int dirfd, const char *file) 
+{
+  return syscall2 (SYS_OPENAT, dirfd, file);
+}
+
+bool
+createat (int dirfd, const char *file, unsigned initial_size) 
+{
+  return syscall3 (SYS_CREATEAT, dirfd, file, initial_size);
+}
+
+bool
+mkdirat (int dirfd, const char *dir) 
+{
+  return syscall2 (SYS_MKDIRAT, dirfd, dir);
+}
+
+bool
+unlinkat (int dirfd, const char *file) 
+{
+  return syscall2 (SYS_UNLINKAT, dirfd, file);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, unsigned offset) 
+{
+  return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, unsigned offset) 
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iov_cnt) 
+{
+  return syscall3 (SYS_READV, fd, iov, iov_cnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iov_cnt) 
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iov_cnt);
+}
+
+int
+copy_file_range (int in_fd, int out_fd, unsigned length) 
+{
+  return syscall3 (SYS_COPY_FILE_RANGE, in_fd, out_fd, length);
+}
+
+pid_t
+fork (void) 
+{
+  return (pid_t) syscall0 (SYS_FORK);
+}
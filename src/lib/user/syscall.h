@@ -3,6 +3,9 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <dirent.h>
+#include <stat.h>
+#include <uio.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -44,5 +47,18 @@ bool mkdir (const char *dir);
 bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
+int getdents (int fd, struct dirent *, unsigned cnt);
+bool stat (const char *file, struct stat *);
+bool fstat (int fd, struct stat *);
+int openat (int dirfd, const char *file);
+bool createat (int dirfd, const char *file, unsigned initial_size);
+bool mkdirat (int dirfd, const char *dir);
+bool unlinkat (int dirfd, const char *file);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int readv (int fd, const struct iovec *, int iov_cnt);
+int writev (int fd, const struct iovec *, int iov_cnt);
+int copy_file_range (int in_fd, int out_fd, unsigned length);
+pid_t fork (void);
 
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,9 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+my ($src) = join ("", map (chr ($_ % 251), 0...9999));
+check_archive ({"src" => [$src x 2],
+               "dst" => ["\0" x 50 . substr ($src, 100)],
+               "dir" => {}});
+pass;
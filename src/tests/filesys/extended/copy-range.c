@@ -0,0 +1,106 @@
+/* Copies between files with copy_file_range(): more than fits in
+   the kernel's 8-sector bounce buffer, from unaligned positions,
+   past the end of the source, and from one part of a file to
+   another through two fds, but never onto the bytes being
+   copied. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE 10000
+
+static char buf[SIZE];
+
+/* Returns byte OFS of "src" as first written. */
+static char
+src_byte (size_t ofs)
+{
+  return ofs % 251;
+}
+
+/* Fails unless the SIZE bytes of FD at OFS are bytes SRC_OFS
+   onward of "src" as first written. */
+static void
+check_copy (int fd, unsigned ofs, size_t src_ofs, size_t size,
+            const char *name)
+{
+  size_t i;
+
+  seek (fd, ofs);
+  if (read (fd, buf, size) != (int) size)
+    fail ("read %zu bytes of \"%s\" at %u", size, name, ofs);
+  for (i = 0; i < size; i++)
+    if (buf[i] != src_byte (src_ofs + i))
+      fail ("byte %zu of \"%s\" is %02hhx, should be %02hhx",
+            ofs + i, name, buf[i], src_byte (src_ofs + i));
+}
+
+void
+test_main (void)
+{
+  static const char zeros[50];
+  int src, dst, src2, dir_fd;
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    buf[i] = src_byte (i);
+  CHECK (create ("src", 0), "create \"src\"");
+  CHECK (create ("dst", 0), "create \"dst\"");
+  CHECK ((src = open ("src")) > 1, "open \"src\"");
+  CHECK ((dst = open ("dst")) > 1, "open \"dst\"");
+  CHECK (write (src, buf, SIZE) == SIZE, "write \"src\"");
+
+  /* More than the bounce buffer holds, from unaligned positions. */
+  seek (src, 100);
+  seek (dst, 50);
+  CHECK (copy_file_range (src, dst, 9000) == 9000, "copy 9000 bytes");
+  CHECK (tell (src) == 9100 && tell (dst) == 9050,
+         "positions moved by 9000");
+
+  /* Past the end of the source. */
+  CHECK (copy_file_range (src, dst, 5000) == 900,
+         "copy 5000 bytes with 900 left copies 900");
+  CHECK (copy_file_range (src, dst, 5000) == 0,
+         "copy at end of source copies 0");
+  CHECK (filesize (dst) == 9950, "\"dst\" is 9950 bytes");
+  seek (dst, 0);
+  CHECK (read (dst, buf, sizeof zeros) == sizeof zeros
+         && !memcmp (buf, zeros, sizeof zeros),
+         "\"dst\" starts with zeros");
+  check_copy (dst, 50, 100, 9900, "dst");
+
+  /* Within one file, through a second fd. */
+  CHECK ((src2 = open ("src")) > 1, "open \"src\" again");
+  seek (src, 0);
+  seek (src2, SIZE);
+  CHECK (copy_file_range (src, src2, SIZE) == SIZE,
+         "copy \"src\" onto its own end");
+  CHECK (filesize (src) == 2 * SIZE, "\"src\" is %d bytes", 2 * SIZE);
+  check_copy (src, 0, 0, SIZE, "src");
+  check_copy (src, SIZE, 0, SIZE, "src");
+
+  /* Never onto the bytes being copied. */
+  seek (src, 0);
+  seek (src2, 100);
+  CHECK (copy_file_range (src, src2, 1000) == -1,
+         "copy onto a later part of the same range (must fail)");
+  CHECK (copy_file_range (src2, src, 1000) == -1,
+         "copy onto an earlier part of the same range (must fail)");
+  CHECK (copy_file_range (src, src, 10) == -1,
+         "copy from an fd to itself (must fail)");
+  CHECK (tell (src) == 0 && tell (src2) == 100, "positions did not move");
+  CHECK (filesize (src) == 2 * SIZE, "\"src\" is still %d bytes", 2 * SIZE);
+  check_copy (src, 0, 0, SIZE, "src");
+
+  /* Bad fds. */
+  CHECK (mkdir ("dir"), "mkdir \"dir\"");
+  CHECK ((dir_fd = open ("dir")) > 1, "open \"dir\"");
+  CHECK (copy_file_range (src, dir_fd, 10) == -1,
+         "copy to a directory (must fail)");
+  CHECK (copy_file_range (dir_fd, dst, 10) == -1,
+         "copy from a directory (must fail)");
+  CHECK (copy_file_range (1234, dst, 10) == -1, "copy from fd 1234 (must fail)");
+  CHECK (copy_file_range (src, 1234, 10) == -1, "copy to fd 1234 (must fail)");
+}
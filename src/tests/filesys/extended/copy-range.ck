@@ -0,0 +1,35 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range) begin
+(copy-range) create "src"
+(copy-range) create "dst"
+(copy-range) open "src"
+(copy-range) open "dst"
+(copy-range) write "src"
+(copy-range) copy 9000 bytes
+(copy-range) positions moved by 9000
+(copy-range) copy 5000 bytes with 900 left copies 900
+(copy-range) copy at end of source copies 0
+(copy-range) "dst" is 9950 bytes
+(copy-range) "dst" starts with zeros
+(copy-range) open "src" again
+(copy-range) copy "src" onto its own end
+(copy-range) "src" is 20000 bytes
+(copy-range) copy onto a later part of the same range (must fail)
+(copy-range) copy onto an earlier part of the same range (must fail)
+(copy-range) copy from an fd to itself (must fail)
+(copy-range) positions did not move
+(copy-range) "src" is still 20000 bytes
+(copy-range) mkdir "dir"
+(copy-range) open "dir"
+(copy-range) copy to a directory (must fail)
+(copy-range) copy from a directory (must fail)
+(copy-range) copy from fd 1234 (must fail)
+(copy-range) copy to fd 1234 (must fail)
+(copy-range) end
+copy-range: exit(0)
+EOF
+pass;
@@ -0,0 +1,158 @@
+/* Lists a directory of 40 files and a subdirectory with getdents(),
+   16 entries at a time, adding and removing files between calls.
+   Every entry that is there throughout must be listed exactly once,
+   and a file removed before it was listed must not be listed. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 40             /* Files created up front. */
+#define ADD_CNT 3               /* Files added while listing. */
+#define BATCH 16                /* Entries per getdents() call. */
+
+static bool seen[FILE_CNT + ADD_CNT];
+static bool removed[FILE_CNT + ADD_CNT];
+static bool sub_seen;
+
+/* Stores the path of file I in the SIZE bytes at PATH, or just
+   its name if NAME_ONLY is true. */
+static void
+file_path (int i, char path[], size_t size, bool name_only)
+{
+  if (i < FILE_CNT)
+    snprintf (path, size, "%sf%d", name_only ? "" : "dir/", i);
+  else
+    snprintf (path, size, "%sn%d", name_only ? "" : "dir/", i - FILE_CNT);
+}
+
+/* Creates file I. */
+static void
+create_file (int i)
+{
+  char path[32];
+
+  file_path (i, path, sizeof path, false);
+  if (!create (path, 0))
+    fail ("create \"%s\"", path);
+}
+
+/* Removes file I. */
+static void
+remove_file (int i)
+{
+  char path[32];
+
+  file_path (i, path, sizeof path, false);
+  if (!remove (path))
+    fail ("remove \"%s\"", path);
+  removed[i] = true;
+}
+
+/* Checks ENT against what has been listed and removed so far. */
+static void
+check_entry (const struct dirent *ent, int sub_ino)
+{
+  char name[16];
+  int i;
+
+  if (!strcmp (ent->d_name, "sub"))
+    {
+      if (sub_seen)
+        fail ("\"sub\" listed twice");
+      if (!ent->d_isdir || ent->d_ino != sub_ino)
+        fail ("\"sub\" listed with the wrong type or inode number");
+      sub_seen = true;
+      return;
+    }
+  for (i = 0; i < FILE_CNT + ADD_CNT; i++)
+    {
+      file_path (i, name, sizeof name, true);
+      if (!strcmp (ent->d_name, name))
+        {
+          if (seen[i])
+            fail ("\"%s\" listed twice", name);
+          if (removed[i])
+            fail ("\"%s\" listed after it was removed", name);
+          if (ent->d_isdir)
+            fail ("\"%s\" listed as a directory", name);
+          seen[i] = true;
+          return;
+        }
+    }
+  fail ("unexpected entry \"%s\"", ent->d_name);
+}
+
+void
+test_main (void)
+{
+  struct dirent ents[BATCH];
+  int fd, sub_fd, sub_ino;
+  int added = 0;
+  int calls = 0;
+  int n, i;
+
+  CHECK (mkdir ("dir"), "mkdir \"dir\"");
+  CHECK (mkdir ("dir/sub"), "mkdir \"dir/sub\"");
+  msg ("create %d files in \"dir\"", FILE_CNT);
+  for (i = 0; i < FILE_CNT; i++)
+    create_file (i);
+  CHECK ((sub_fd = open ("dir/sub")) > 1, "open \"dir/sub\"");
+  sub_ino = inumber (sub_fd);
+  close (sub_fd);
+
+  CHECK ((fd = open ("dir")) > 1, "open \"dir\"");
+  CHECK (getdents (fd, ents, 0) == 0, "getdents with no room for an entry");
+
+  msg ("getdents %d at a time, adding and removing files between calls",
+       BATCH);
+  while ((n = getdents (fd, ents, BATCH)) > 0)
+    {
+      if (n > BATCH)
+        fail ("getdents returned %d entries for room for %d", n, BATCH);
+      for (i = 0; i < n; i++)
+        check_entry (&ents[i], sub_ino);
+      calls++;
+
+      /* Add a file, and remove one file that has been listed and
+         one that has not. */
+      if (added < ADD_CNT)
+        {
+          create_file (FILE_CNT + added++);
+          for (i = 0; i < FILE_CNT; i++)
+            if (seen[i] && !removed[i])
+              {
+                remove_file (i);
+                break;
+              }
+          for (i = 0; i < FILE_CNT; i++)
+            if (!seen[i] && !removed[i])
+              {
+                remove_file (i);
+                break;
+              }
+        }
+    }
+  if (n < 0)
+    fail ("getdents failed");
+  if (calls < 3)
+    fail ("listing took only %d calls", calls);
+  if (!sub_seen)
+    fail ("\"sub\" not listed");
+  for (i = 0; i < FILE_CNT; i++)
+    if (!seen[i] && !removed[i])
+      fail ("\"f%d\" not listed", i);
+  msg ("every entry listed once");
+  close (fd);
+
+  msg ("remove the remaining files");
+  for (i = 0; i < FILE_CNT + ADD_CNT; i++)
+    if (!removed[i])
+      remove_file (i);
+  CHECK ((fd = open ("dir")) > 1, "open \"dir\"");
+  CHECK (getdents (fd, ents, BATCH) == 1 && !strcmp (ents[0].d_name, "sub"),
+         "getdents lists only \"sub\"");
+  CHECK (getdents (fd, ents, BATCH) == 0, "getdents at end of directory");
+}
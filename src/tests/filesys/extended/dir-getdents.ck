@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(dir-getdents) begin
+(dir-getdents) mkdir "dir"
+(dir-getdents) mkdir "dir/sub"
+(dir-getdents) create 40 files in "dir"
+(dir-getdents) open "dir/sub"
+(dir-getdents) open "dir"
+(dir-getdents) getdents with no room for an entry
+(dir-getdents) getdents 16 at a time, adding and removing files between calls
+(dir-getdents) every entry listed once
+(dir-getdents) remove the remaining files
+(dir-getdents) open "dir"
+(dir-getdents) getdents lists only "sub"
+(dir-getdents) getdents at end of directory
+(dir-getdents) end
+dir-getdents: exit(0)
+EOF
+pass;
@@ -0,0 +1,41 @@
+/* Calls the *at() functions with a dirfd that is an ordinary
+   file, that was closed, or that was never open.  Each call must
+   fail without creating, opening, or removing anything. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Checks that each *at() call fails with DIRFD, which DESC
+   describes. */
+static void
+check_bad_dirfd (int dirfd, const char *desc)
+{
+  CHECK (openat (dirfd, "file") == -1, "openat with %s (must fail)", desc);
+  CHECK (!createat (dirfd, "x", 0), "createat with %s (must fail)", desc);
+  CHECK (!mkdirat (dirfd, "y"), "mkdirat with %s (must fail)", desc);
+  CHECK (!unlinkat (dirfd, "file"), "unlinkat with %s (must fail)", desc);
+}
+
+void
+test_main (void)
+{
+  int fd, dir_fd;
+
+  CHECK (create ("file", 0), "create \"file\"");
+  CHECK (mkdir ("dir"), "mkdir \"dir\"");
+  CHECK ((fd = open ("file")) > 1, "open \"file\"");
+  CHECK ((dir_fd = open ("dir")) > 1, "open \"dir\"");
+  close (dir_fd);
+
+  check_bad_dirfd (fd, "an ordinary file");
+  check_bad_dirfd (dir_fd, "a closed fd");
+  check_bad_dirfd (1234, "fd 1234");
+  check_bad_dirfd (-1, "fd -1");
+  check_bad_dirfd (STDIN_FILENO, "stdin");
+
+  CHECK (open ("x") == -1 && open ("dir/x") == -1, "\"x\" was not created");
+  CHECK (open ("y") == -1 && open ("dir/y") == -1, "\"y\" was not created");
+  CHECK ((fd = open ("file")) > 1, "\"file\" was not removed");
+}
@@ -0,0 +1,37 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(dir-openat-bad) begin
+(dir-openat-bad) create "file"
+(dir-openat-bad) mkdir "dir"
+(dir-openat-bad) open "file"
+(dir-openat-bad) open "dir"
+(dir-openat-bad) openat with an ordinary file (must fail)
+(dir-openat-bad) createat with an ordinary file (must fail)
+(dir-openat-bad) mkdirat with an ordinary file (must fail)
+(dir-openat-bad) unlinkat with an ordinary file (must fail)
+(dir-openat-bad) openat with a closed fd (must fail)
+(dir-openat-bad) createat with a closed fd (must fail)
+(dir-openat-bad) mkdirat with a closed fd (must fail)
+(dir-openat-bad) unlinkat with a closed fd (must fail)
+(dir-openat-bad) openat with fd 1234 (must fail)
+(dir-openat-bad) createat with fd 1234 (must fail)
+(dir-openat-bad) mkdirat with fd 1234 (must fail)
+(dir-openat-bad) unlinkat with fd 1234 (must fail)
+(dir-openat-bad) openat with fd -1 (must fail)
+(dir-openat-bad) createat with fd -1 (must fail)
+(dir-openat-bad) mkdirat with fd -1 (must fail)
+(dir-openat-bad) unlinkat with fd -1 (must fail)
+(dir-openat-bad) openat with stdin (must fail)
+(dir-openat-bad) createat with stdin (must fail)
+(dir-openat-bad) mkdirat with stdin (must fail)
+(dir-openat-bad) unlinkat with stdin (must fail)
+(dir-openat-bad) "x" was not created
+(dir-openat-bad) "y" was not created
+(dir-openat-bad) "file" was not removed
+(dir-openat-bad) end
+dir-openat-bad: exit(0)
+EOF
+pass;
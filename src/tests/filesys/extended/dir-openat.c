@@ -0,0 +1,48 @@
+/* Creates, opens, and removes files and directories with the
+   *at() calls, checking that relative names are resolved from the
+   dirfd and absolute names from the root. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  int a_fd, fd, fd2;
+
+  CHECK (mkdir ("a"), "mkdir \"a\"");
+  CHECK (mkdir ("a/b"), "mkdir \"a/b\"");
+  CHECK ((a_fd = open ("a")) > 1, "open \"a\"");
+
+  /* Relative names. */
+  CHECK (createat (a_fd, "f", 10), "createat \"f\" in \"a\"");
+  CHECK ((fd = open ("a/f")) > 1, "open \"a/f\"");
+  CHECK (filesize (fd) == 10, "\"a/f\" is 10 bytes");
+  CHECK (!createat (a_fd, "f", 0), "createat \"f\" in \"a\" again (must fail)");
+  CHECK (mkdirat (a_fd, "b/c"), "mkdirat \"b/c\" in \"a\"");
+  CHECK ((fd2 = openat (a_fd, "b/c")) > 1, "openat \"b/c\" in \"a\"");
+  CHECK (isdir (fd2), "\"a/b/c\" is a directory");
+  close (fd2);
+  CHECK ((fd2 = openat (a_fd, "../a/f")) > 1, "openat \"../a/f\" in \"a\"");
+  CHECK (inumber (fd2) == inumber (fd), "\"../a/f\" is \"a/f\"");
+  close (fd2);
+  CHECK (openat (a_fd, "a/f") == -1, "openat \"a/f\" in \"a\" (must fail)");
+
+  /* Absolute names. */
+  CHECK (createat (a_fd, "/g", 5), "createat \"/g\" in \"a\"");
+  CHECK (open ("a/g") == -1, "open \"a/g\" (must fail)");
+  CHECK ((fd2 = open ("/g")) > 1, "open \"/g\"");
+  close (fd2);
+  CHECK ((fd2 = openat (a_fd, "/a/f")) > 1, "openat \"/a/f\" in \"a\"");
+  CHECK (inumber (fd2) == inumber (fd), "\"/a/f\" is \"a/f\"");
+  close (fd2);
+  CHECK (unlinkat (a_fd, "/g"), "unlinkat \"/g\" in \"a\"");
+  CHECK (open ("/g") == -1, "open \"/g\" (must fail)");
+
+  /* Removal. */
+  CHECK (!unlinkat (a_fd, "b"), "unlinkat non-empty \"b\" in \"a\" (must fail)");
+  CHECK (unlinkat (a_fd, "f"), "unlinkat \"f\" in \"a\"");
+  CHECK (open ("a/f") == -1, "open \"a/f\" (must fail)");
+  CHECK (!unlinkat (a_fd, "f"), "unlinkat \"f\" in \"a\" again (must fail)");
+}
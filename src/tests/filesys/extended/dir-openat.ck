@@ -0,0 +1,34 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(dir-openat) begin
+(dir-openat) mkdir "a"
+(dir-openat) mkdir "a/b"
+(dir-openat) open "a"
+(dir-openat) createat "f" in "a"
+(dir-openat) open "a/f"
+(dir-openat) "a/f" is 10 bytes
+(dir-openat) createat "f" in "a" again (must fail)
+(dir-openat) mkdirat "b/c" in "a"
+(dir-openat) openat "b/c" in "a"
+(dir-openat) "a/b/c" is a directory
+(dir-openat) openat "../a/f" in "a"
+(dir-openat) "../a/f" is "a/f"
+(dir-openat) openat "a/f" in "a" (must fail)
+(dir-openat) createat "/g" in "a"
+(dir-openat) open "a/g" (must fail)
+(dir-openat) open "/g"
+(dir-openat) openat "/a/f" in "a"
+(dir-openat) "/a/f" is "a/f"
+(dir-openat) unlinkat "/g" in "a"
+(dir-openat) open "/g" (must fail)
+(dir-openat) unlinkat non-empty "b" in "a" (must fail)
+(dir-openat) unlinkat "f" in "a"
+(dir-openat) open "a/f" (must fail)
+(dir-openat) unlinkat "f" in "a" again (must fail)
+(dir-openat) end
+dir-openat: exit(0)
+EOF
+pass;
@@ -0,0 +1,8 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_archive ({"file" => ["012ab56789" . "\0" x 590 . "xyz"
+                           . "\0" x (70000 - 603) . "!"],
+                "dir" => {}});
+pass;
@@ -0,0 +1,82 @@
+/* Reads and writes a file with pread() and pwrite(), checking that
+   neither moves the file position, that reads stop at end of file,
+   and that writes past the end extend the file with zeros. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FAR_OFS 70000           /* Well past the direct blocks. */
+
+static char buf[4096];
+
+/* Fails unless the SIZE bytes of FD at OFS are all zero. */
+static void
+check_zeros (int fd, unsigned ofs, unsigned size)
+{
+  while (size > 0)
+    {
+      unsigned chunk = size < sizeof buf ? size : sizeof buf;
+      unsigned i;
+
+      if (pread (fd, buf, chunk, ofs) != (int) chunk)
+        fail ("pread %u bytes at %u", chunk, ofs);
+      for (i = 0; i < chunk; i++)
+        if (buf[i] != 0)
+          fail ("byte %u is %02hhx, should be 0", ofs + i, buf[i]);
+      ofs += chunk;
+      size -= chunk;
+    }
+}
+
+void
+test_main (void)
+{
+  int fd, dir_fd;
+
+  CHECK (create ("file", 0), "create \"file\"");
+  CHECK ((fd = open ("file")) > 1, "open \"file\"");
+  CHECK (write (fd, "0123456789", 10) == 10, "write \"file\"");
+
+  /* The position stays at 10 throughout. */
+  CHECK (pwrite (fd, "ab", 2, 3) == 2, "pwrite 2 bytes at 3");
+  CHECK (tell (fd) == 10, "position is still 10");
+  CHECK (pread (fd, buf, 4, 2) == 4 && !memcmp (buf, "2ab5", 4),
+         "pread 4 bytes at 2");
+  CHECK (tell (fd) == 10, "position is still 10");
+
+  /* Reads stop at end of file. */
+  CHECK (pread (fd, buf, 10, 5) == 5 && !memcmp (buf, "56789", 5),
+         "pread 10 bytes at 5 reads 5");
+  CHECK (pread (fd, buf, 10, 10) == 0, "pread at end of file reads 0");
+  CHECK (pread (fd, buf, 10, 5000) == 0, "pread past end of file reads 0");
+
+  /* Writes past the end extend the file. */
+  CHECK (pwrite (fd, "xyz", 3, 600) == 3, "pwrite 3 bytes at 600");
+  CHECK (filesize (fd) == 603, "file is 603 bytes");
+  check_zeros (fd, 10, 590);
+  CHECK (pread (fd, buf, 3, 600) == 3 && !memcmp (buf, "xyz", 3),
+         "pread 3 bytes at 600");
+  CHECK (pwrite (fd, "!", 1, FAR_OFS) == 1, "pwrite 1 byte at %d", FAR_OFS);
+  CHECK (filesize (fd) == FAR_OFS + 1, "file is %d bytes", FAR_OFS + 1);
+  check_zeros (fd, 603, FAR_OFS - 603);
+  CHECK (tell (fd) == 10, "position is still 10");
+  CHECK (read (fd, buf, 2) == 2 && !memcmp (buf, "\0\0", 2),
+         "read from position 10");
+
+  /* No file reaches past INT32_MAX bytes. */
+  CHECK (pwrite (fd, "0123456789", 10, INT32_MAX - 5) == -1,
+         "pwrite 10 bytes at INT32_MAX - 5 (must fail)");
+  CHECK (filesize (fd) == FAR_OFS + 1, "file is still %d bytes", FAR_OFS + 1);
+  CHECK (pread (fd, buf, 10, INT32_MAX - 5) == 0,
+         "pread 10 bytes at INT32_MAX - 5 reads 0");
+
+  /* Bad fds. */
+  CHECK (mkdir ("dir"), "mkdir \"dir\"");
+  CHECK ((dir_fd = open ("dir")) > 1, "open \"dir\"");
+  CHECK (pwrite (dir_fd, "x", 1, 0) == -1, "pwrite to directory (must fail)");
+  CHECK (pread (1234, buf, 1, 0) == -1, "pread fd 1234 (must fail)");
+  CHECK (pwrite (1234, "x", 1, 0) == -1, "pwrite fd 1234 (must fail)");
+}
@@ -0,0 +1,35 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) create "file"
+(pread-pwrite) open "file"
+(pread-pwrite) write "file"
+(pread-pwrite) pwrite 2 bytes at 3
+(pread-pwrite) position is still 10
+(pread-pwrite) pread 4 bytes at 2
+(pread-pwrite) position is still 10
+(pread-pwrite) pread 10 bytes at 5 reads 5
+(pread-pwrite) pread at end of file reads 0
+(pread-pwrite) pread past end of file reads 0
+(pread-pwrite) pwrite 3 bytes at 600
+(pread-pwrite) file is 603 bytes
+(pread-pwrite) pread 3 bytes at 600
+(pread-pwrite) pwrite 1 byte at 70000
+(pread-pwrite) file is 70001 bytes
+(pread-pwrite) position is still 10
+(pread-pwrite) read from position 10
+(pread-pwrite) pwrite 10 bytes at INT32_MAX - 5 (must fail)
+(pread-pwrite) file is still 70001 bytes
+(pread-pwrite) pread 10 bytes at INT32_MAX - 5 reads 0
+(pread-pwrite) mkdir "dir"
+(pread-pwrite) open "dir"
+(pread-pwrite) pwrite to directory (must fail)
+(pread-pwrite) pread fd 1234 (must fail)
+(pread-pwrite) pwrite fd 1234 (must fail)
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
@@ -0,0 +1,27 @@
+/* Passes readv() a good buffer followed by one in kernel memory.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  struct iovec iov[2];
+  char buf[5];
+  int fd;
+
+  CHECK (create ("file", 0), "create \"file\"");
+  CHECK ((fd = open ("file")) > 1, "open \"file\"");
+  CHECK (write (fd, "0123456789", 10) == 10, "write \"file\"");
+  seek (fd, 0);
+
+  iov[0].iov_base = buf;
+  iov[0].iov_len = sizeof buf;
+  iov[1].iov_base = (void *) 0xc0100000;
+  iov[1].iov_len = 5;
+  msg ("readv into a buffer in kernel memory");
+  readv (fd, iov, 2);
+  fail ("should not have survived readv()");
+}
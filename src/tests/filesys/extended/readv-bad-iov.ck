@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-bad-iov) begin
+(readv-bad-iov) create "file"
+(readv-bad-iov) open "file"
+(readv-bad-iov) write "file"
+(readv-bad-iov) readv into a buffer in kernel memory
+readv-bad-iov: exit(-1)
+EOF
+pass;
@@ -0,0 +1,6 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_archive ({"file" => ["abcdefghij" . join ("", map (chr (ord ("A") + $_ % 26), 0...63))]});
+pass;
@@ -0,0 +1,86 @@
+/* Writes a file with writev() and reads it back with readv(),
+   with zero-length buffers, no buffers, and as many buffers as
+   IOV_MAX allows, and checks that one buffer more fails. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct iovec iov[IOV_MAX + 1];
+static char bytes[IOV_MAX + 1];
+
+/* Sets IOV[I] to the SIZE bytes at BASE. */
+static void
+set_iov (int i, const void *base, size_t size)
+{
+  iov[i].iov_base = (void *) base;
+  iov[i].iov_len = size;
+}
+
+void
+test_main (void)
+{
+  char prefix[32];
+  char a[4], b[6];
+  int fd, retval, i;
+
+  CHECK (create ("file", 0), "create \"file\"");
+  CHECK ((fd = open ("file")) > 1, "open \"file\"");
+
+  /* Zero-length buffers are skipped. */
+  set_iov (0, "abc", 3);
+  set_iov (1, NULL, 0);
+  set_iov (2, "defgh", 5);
+  set_iov (3, a, 0);
+  set_iov (4, "ij", 2);
+  CHECK (writev (fd, iov, 5) == 10, "writev 5 buffers");
+  CHECK (tell (fd) == 10, "position is 10");
+  seek (fd, 0);
+  set_iov (0, a, sizeof a);
+  set_iov (1, NULL, 0);
+  set_iov (2, b, sizeof b);
+  CHECK (readv (fd, iov, 3) == 10
+         && !memcmp (a, "abcd", 4) && !memcmp (b, "efghij", 6),
+         "readv 3 buffers");
+  CHECK (readv (fd, iov, 3) == 0, "readv at end of file reads 0");
+
+  /* No buffers. */
+  CHECK (writev (fd, iov, 0) == 0, "writev 0 buffers");
+  CHECK (readv (fd, iov, 0) == 0, "readv 0 buffers");
+
+  /* IOV_MAX one-byte buffers, and one more. */
+  for (i = 0; i < IOV_MAX + 1; i++)
+    {
+      bytes[i] = 'A' + i % 26;
+      set_iov (i, &bytes[i], 1);
+    }
+  CHECK (writev (fd, iov, IOV_MAX) == IOV_MAX, "writev %d buffers", IOV_MAX);
+  CHECK (writev (fd, iov, IOV_MAX + 1) == -1,
+         "writev %d buffers (must fail)", IOV_MAX + 1);
+  CHECK (writev (fd, iov, -1) == -1, "writev -1 buffers (must fail)");
+  CHECK (filesize (fd) == 10 + IOV_MAX, "file is %d bytes", 10 + IOV_MAX);
+  seek (fd, 10);
+  memset (bytes, 0, sizeof bytes);
+  CHECK (readv (fd, iov, IOV_MAX + 1) == -1,
+         "readv %d buffers (must fail)", IOV_MAX + 1);
+  CHECK (readv (fd, iov, IOV_MAX) == IOV_MAX, "readv %d buffers", IOV_MAX);
+  for (i = 0; i < IOV_MAX; i++)
+    if (bytes[i] != 'A' + i % 26)
+      fail ("byte %d is %c, should be %c", i, bytes[i], 'A' + i % 26);
+  if (bytes[IOV_MAX] != 0)
+    fail ("readv read into buffer %d", IOV_MAX);
+
+  /* The console, and bad fds. */
+  snprintf (prefix, sizeof prefix, "(%s) ", test_name);
+  set_iov (0, prefix, strlen (prefix));
+  set_iov (1, "writev ", 7);
+  set_iov (2, NULL, 0);
+  set_iov (3, "to stdout\n", 10);
+  retval = writev (STDOUT_FILENO, iov, 4);
+  CHECK (retval == (int) strlen (prefix) + 17,
+         "writev to stdout returned the bytes written");
+  CHECK (writev (1234, iov, 1) == -1, "writev fd 1234 (must fail)");
+  CHECK (readv (1234, iov, 1) == -1, "readv fd 1234 (must fail)");
+}
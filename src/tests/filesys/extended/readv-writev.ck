@@ -0,0 +1,28 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-writev) begin
+(readv-writev) create "file"
+(readv-writev) open "file"
+(readv-writev) writev 5 buffers
+(readv-writev) position is 10
+(readv-writev) readv 3 buffers
+(readv-writev) readv at end of file reads 0
+(readv-writev) writev 0 buffers
+(readv-writev) readv 0 buffers
+(readv-writev) writev 64 buffers
+(readv-writev) writev 65 buffers (must fail)
+(readv-writev) writev -1 buffers (must fail)
+(readv-writev) file is 74 bytes
+(readv-writev) readv 65 buffers (must fail)
+(readv-writev) readv 64 buffers
+(readv-writev) writev to stdout
+(readv-writev) writev to stdout returned the bytes written
+(readv-writev) writev fd 1234 (must fail)
+(readv-writev) readv fd 1234 (must fail)
+(readv-writev) end
+readv-writev: exit(0)
+EOF
+pass;
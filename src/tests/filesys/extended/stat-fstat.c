@@ -0,0 +1,66 @@
+/* Checks the size, inode number, and type that stat() and fstat()
+   report for a file and a directory, and that both fail, leaving
+   the struct stat alone, for a bad name or fd. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Fails unless *ST describes a SIZE-byte ordinary file, or a
+   directory if IS_DIR, whose inode number is INO.  The size is
+   not checked if SIZE is negative.  NAME is for messages. */
+static void
+check_stat (const struct stat *st, int size, bool is_dir, int ino,
+            const char *name)
+{
+  if (st->st_isdir != is_dir)
+    fail ("\"%s\" has st_isdir %d", name, st->st_isdir);
+  if (size >= 0 && st->st_size != size)
+    fail ("\"%s\" has st_size %d, should be %d", name, st->st_size, size);
+  if (st->st_ino != ino)
+    fail ("\"%s\" has st_ino %d, should be %d", name, st->st_ino, ino);
+}
+
+void
+test_main (void)
+{
+  static char buf[100];
+  struct stat st, fst, untouched;
+  int fd, dir_fd;
+
+  CHECK (create ("file", 1234), "create \"file\"");
+  CHECK (mkdir ("dir"), "mkdir \"dir\"");
+  CHECK ((fd = open ("file")) > 1, "open \"file\"");
+  CHECK ((dir_fd = open ("dir")) > 1, "open \"dir\"");
+
+  CHECK (stat ("file", &st), "stat \"file\"");
+  check_stat (&st, 1234, false, inumber (fd), "file");
+  CHECK (fstat (fd, &fst), "fstat \"file\"");
+  check_stat (&fst, 1234, false, inumber (fd), "file");
+
+  memset (buf, 'a', sizeof buf);
+  seek (fd, 1234);
+  CHECK (write (fd, buf, sizeof buf) == sizeof buf, "write \"file\"");
+  CHECK (fstat (fd, &fst), "fstat \"file\"");
+  check_stat (&fst, 1234 + sizeof buf, false, inumber (fd), "file");
+
+  CHECK (stat ("dir", &st), "stat \"dir\"");
+  check_stat (&st, -1, true, inumber (dir_fd), "dir");
+  CHECK (fstat (dir_fd, &fst), "fstat \"dir\"");
+  check_stat (&fst, st.st_size, true, inumber (dir_fd), "dir");
+  CHECK (stat ("/dir/..", &st), "stat \"/dir/..\"");
+  CHECK (st.st_isdir && st.st_ino != fst.st_ino,
+         "\"/dir/..\" is another directory");
+
+  memset (&st, 0x5a, sizeof st);
+  untouched = st;
+  CHECK (!stat ("no-such-file", &st), "stat \"no-such-file\" (must fail)");
+  CHECK (!stat ("dir/no-such-file", &st),
+         "stat \"dir/no-such-file\" (must fail)");
+  CHECK (!fstat (1234, &st), "fstat 1234 (must fail)");
+  close (fd);
+  CHECK (!fstat (fd, &st), "fstat closed fd (must fail)");
+  CHECK (!memcmp (&st, &untouched, sizeof st),
+         "failed calls left the struct stat alone");
+}
@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(stat-fstat) begin
+(stat-fstat) create "file"
+(stat-fstat) mkdir "dir"
+(stat-fstat) open "file"
+(stat-fstat) open "dir"
+(stat-fstat) stat "file"
+(stat-fstat) fstat "file"
+(stat-fstat) write "file"
+(stat-fstat) fstat "file"
+(stat-fstat) stat "dir"
+(stat-fstat) fstat "dir"
+(stat-fstat) stat "/dir/.."
+(stat-fstat) "/dir/.." is another directory
+(stat-fstat) stat "no-such-file" (must fail)
+(stat-fstat) stat "dir/no-such-file" (must fail)
+(stat-fstat) fstat 1234 (must fail)
+(stat-fstat) fstat closed fd (must fail)
+(stat-fstat) failed calls left the struct stat alone
+(stat-fstat) end
+stat-fstat: exit(0)
+EOF
+pass;
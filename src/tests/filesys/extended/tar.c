@@ -34,10 +34,12 @@ usage (void)
 }
 
 static bool archive_file (char file_name[], size_t file_name_size,
+                          int dir_fd, const char *rel_name,
                           int archive_fd, bool *write_error);
 
 static bool archive_ordinary_file (const char *file_name, int file_fd,
-                                   int archive_fd, bool *write_error);
+                                   int file_size, int archive_fd,
+                                   bool *write_error);
 static bool archive_directory (char file_name[], size_t file_name_size,
                                int file_fd, int archive_fd, bool *write_error);
 static bool write_header (const char *file_name, enum ustar_type, int size,
@@ -71,7 +73,7 @@ make_tar_archive (const char *archive_name, char *files[], size_t file_cnt)
       char file_name[128];
       
       strlcpy (file_name, files[i], sizeof file_name);
-      if (!archive_file (file_name, sizeof file_name,
+      if (!archive_file (file_name, sizeof file_name, -1, file_name,
                          archive_fd, &write_error))
         success = false;
     }
@@ -85,19 +87,25 @@ make_tar_archive (const char *archive_name, char *files[], size_t file_cnt)
   return success;
 }
 
+/* Archives FILE_NAME.  If DIR_FD is a directory's fd, opens the
+   file as REL_NAME within it, to avoid walking the whole path. */
 static bool
 archive_file (char file_name[], size_t file_name_size,
+              int dir_fd, const char *rel_name,
               int archive_fd, bool *write_error) 
 {
-  int file_fd = open (file_name);
-  if (file_fd >= 0) 
+  int file_fd = dir_fd >= 0 ? openat (dir_fd, rel_name) : open (file_name);
+  struct stat file_st, archive_st;
+  if (file_fd >= 0
+      && fstat (file_fd, &file_st) && fstat (archive_fd, &archive_st)) 
     {
       bool success;
 
-      if (inumber (file_fd) != inumber (archive_fd)) 
+      if (file_st.st_ino != archive_st.st_ino) 
         {
-          if (!isdir (file_fd))
+          if (!file_st.st_isdir)
             success = archive_ordinary_file (file_name, file_fd,
+                                             file_st.st_size,
                                              archive_fd, write_error);
           else
             success = archive_directory (file_name, file_name_size, file_fd,
@@ -116,17 +124,17 @@ archive_file (char file_name[], size_t file_name_size,
   else
     {
       printf ("%s: open failed\n", file_name);
+      close (file_fd);
       return false;
     }
 }
 
 static bool
 archive_ordinary_file (const char *file_name, int file_fd,
-                       int archive_fd, bool *write_error)
+                       int file_size, int archive_fd, bool *write_error)
 {
   bool read_error = false;
   bool success = true;
-  int file_size = filesize (file_fd);
 
   if (!write_header (file_name, USTAR_REGULAR, file_size,
                      archive_fd, write_error))
@@ -175,7 +183,9 @@ archive_directory (char file_name[], size_t file_name_size, int file_fd,
       
   file_name[dir_len] = '/';
   while (readdir (file_fd, &file_name[dir_len + 1])) 
-    if (!archive_file (file_name, file_name_size, archive_fd, write_error))
+    if (!archive_file (file_name, file_name_size,
+                       file_fd, &file_name[dir_len + 1],
+                       archive_fd, write_error))
       success = false;
   file_name[dir_len] = '\0';
 
@@ -0,0 +1,25 @@
+/* Passes writev() a good buffer followed by a null one.  The
+   process must be terminated with -1 exit code, without writing
+   the good buffer. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  struct iovec iov[2];
+  int fd;
+
+  CHECK (create ("file", 0), "create \"file\"");
+  CHECK ((fd = open ("file")) > 1, "open \"file\"");
+
+  iov[0].iov_base = "abc";
+  iov[0].iov_len = 3;
+  iov[1].iov_base = NULL;
+  iov[1].iov_len = 5;
+  msg ("writev from a null buffer");
+  writev (fd, iov, 2);
+  fail ("should not have survived writev()");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(writev-bad-iov) begin
+(writev-bad-iov) create "file"
+(writev-bad-iov) open "file"
+(writev-bad-iov) writev from a null buffer
+writev-bad-iov: exit(-1)
+EOF
+pass;
@@ -0,0 +1,108 @@
+/* Times bitmap_scan() on bitmaps the size of the free map of a
+   64 MB and a 1 GB disk (one bit per 512-byte sector) that are
+   nearly full, first bit-at-a-time as the old scan did, then with
+   the word-at-a-time scan, then with the summary layer enabled.
+   Every answer is checked against the bit-at-a-time scan.
+
+   This is a benchmark, not a graded test.  Run it by hand with
+   "pintos -- run bitmap-bench". */
+
+#include <bitmap.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "devices/timer.h"
+
+/* Number of timed scans per measurement. */
+#define SCAN_REPS 10
+
+/* Sectors in 64 MB and 1 GB disks. */
+#define SECTORS_64MB (64 * 1024 * 1024 / 512)
+#define SECTORS_1GB (1024 * 1024 * 1024 / 512)
+
+/* Reference scan, testing one candidate bit at a time. */
+static size_t
+slow_scan (const struct bitmap *b, size_t cnt)
+{
+  size_t i, j;
+
+  for (i = 0; i + cnt <= bitmap_size (b); i++)
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j))
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Scans B for CNT free bits SCAN_REPS times, with the reference
+   scan if SLOW, and returns the elapsed ticks.  Fails the test if
+   the result differs from EXPECTED. */
+static int64_t
+time_scan (const struct bitmap *b, size_t cnt, bool slow, size_t expected)
+{
+  int64_t start = timer_ticks ();
+  int i;
+
+  for (i = 0; i < SCAN_REPS; i++)
+    {
+      size_t idx = slow ? slow_scan (b, cnt) : bitmap_scan (b, 0, cnt, false);
+      if (idx != expected)
+        fail ("scan for %zu free bits found %zu, expected %zu",
+              cnt, idx, expected);
+    }
+  return timer_elapsed (start);
+}
+
+/* Returns a new BIT_CNT-bit map with only a handful of free bits:
+   isolated ones toward the end, and one run of 8 at the very end. */
+static struct bitmap *
+make_nearly_full (size_t bit_cnt)
+{
+  struct bitmap *b = bitmap_create (bit_cnt);
+  size_t i;
+
+  if (b == NULL)
+    fail ("can't allocate %zu-bit bitmap", bit_cnt);
+  bitmap_set_all (b, true);
+  for (i = bit_cnt - bit_cnt / 16; i < bit_cnt - 8; i += 97)
+    bitmap_reset (b, i);
+  bitmap_set_multiple (b, bit_cnt - 8, 8, false);
+  return b;
+}
+
+/* Benchmarks scans for 1 and 8 free bits in a nearly full
+   BIT_CNT-bit map. */
+static void
+bench (const char *name, size_t bit_cnt)
+{
+  static const size_t cnts[] = {1, 8};
+  size_t i;
+
+  for (i = 0; i < sizeof cnts / sizeof *cnts; i++)
+    {
+      struct bitmap *b = make_nearly_full (bit_cnt);
+      size_t expected = slow_scan (b, cnts[i]);
+      int64_t slow_ticks = time_scan (b, cnts[i], true, expected);
+      int64_t word_ticks = time_scan (b, cnts[i], false, expected);
+      int64_t summary_ticks;
+
+      if (!bitmap_enable_summary (b))
+        fail ("can't allocate summary for %zu-bit bitmap", bit_cnt);
+      summary_ticks = time_scan (b, cnts[i], false, expected);
+      bitmap_destroy (b);
+
+      msg ("%s, %zu free: %d scans took %lld ticks bit-at-a-time, "
+           "%lld word-at-a-time, %lld with summary",
+           name, cnts[i], SCAN_REPS, slow_ticks, word_ticks, summary_ticks);
+    }
+}
+
+void
+test_bitmap_bench (void) 
+{
+  bench ("64 MB disk", SECTORS_64MB);
+  bench ("1 GB disk", SECTORS_1GB);
+  pass ();
+}
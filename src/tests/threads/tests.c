@@ -18,6 +18,7 @@ static const struct test tests[] =
     {"alarm-negative", test_alarm_negative},
     {"producer-consumer", test_producer_consumer},
     {"narrow-bridge", test_narrow_bridge},
+    {"bitmap-bench", test_bitmap_bench},
   };
 
 static const char *test_name;
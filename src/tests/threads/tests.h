@@ -12,6 +12,7 @@ extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
 extern test_func test_producer_consumer;
 extern test_func test_narrow_bridge;
+extern test_func test_bitmap_bench;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
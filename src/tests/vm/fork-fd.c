@@ -0,0 +1,42 @@
+/* Checks that a forked child's fds start where the parent's are,
+   for both a file and a directory, and then move on their own. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char buf[10];
+  char first[READDIR_MAX_LEN + 1];
+  char name[READDIR_MAX_LEN + 1];
+  int fd, dir_fd;
+  pid_t pid;
+
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (read (fd, buf, sizeof buf) == sizeof buf, "read \"sample.txt\"");
+  CHECK ((dir_fd = open ("/")) > 1, "open \"/\"");
+  CHECK (readdir (dir_fd, first), "readdir \"/\"");
+
+  pid = fork ();
+  if (pid == 0)
+    {
+      if (tell (fd) != sizeof buf)
+        fail ("child's file position is %u", tell (fd));
+      if (read (fd, buf, sizeof buf) != sizeof buf
+          || memcmp (buf, sample + sizeof buf, sizeof buf))
+        fail ("child read bad data");
+      if (!readdir (dir_fd, name) || !strcmp (name, first))
+        fail ("child's readdir started over");
+      exit (0);
+    }
+  if (pid == PID_ERROR)
+    fail ("fork");
+  CHECK (wait (pid) == 0, "wait for child");
+  CHECK (tell (fd) == sizeof buf, "parent's file position is unchanged");
+  CHECK (readdir (dir_fd, name) && strcmp (name, first),
+         "parent's readdir goes on from where it was");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-fd) begin
+(fork-fd) open "sample.txt"
+(fork-fd) read "sample.txt"
+(fork-fd) open "/"
+(fork-fd) readdir "/"
+fork-fd: exit(0)
+(fork-fd) wait for child
+(fork-fd) parent's file position is unchanged
+(fork-fd) parent's readdir goes on from where it was
+(fork-fd) end
+fork-fd: exit(0)
+EOF
+pass;
@@ -0,0 +1,37 @@
+/* Maps a file into memory and forks.  The child writes to the
+   mapping, which the parent then sees, because mappings stay
+   shared across fork(). */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  int handle;
+  pid_t pid;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (handle, actual) != MAP_FAILED, "mmap \"sample.txt\"");
+  if (memcmp (actual, sample, strlen (sample)))
+    fail ("read of mmap'd file reported bad data");
+
+  pid = fork ();
+  if (pid == 0)
+    {
+      if (memcmp (actual, sample, strlen (sample)))
+        fail ("child's mapping has bad data");
+      memcpy (actual, "child", 5);
+      exit (0);
+    }
+  if (pid == PID_ERROR)
+    fail ("fork");
+  CHECK (wait (pid) == 0, "wait for child");
+  CHECK (!memcmp (actual, "child", 5)
+         && !memcmp (actual + 5, sample + 5, strlen (sample) - 5),
+         "parent sees the child's write");
+}
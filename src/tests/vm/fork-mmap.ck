@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-mmap) begin
+(fork-mmap) open "sample.txt"
+(fork-mmap) mmap "sample.txt"
+fork-mmap: exit(0)
+(fork-mmap) wait for child
+(fork-mmap) parent sees the child's write
+(fork-mmap) end
+fork-mmap: exit(0)
+EOF
+pass;
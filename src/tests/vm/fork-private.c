@@ -0,0 +1,48 @@
+/* Checks that writes to data, BSS, and stack pages after fork()
+   are seen only by the process that makes them. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int data_var = 1;
+static int bss_var;
+
+/* Spins for a while, so that the parent likely writes its copies
+   of the variables before the child reads them. */
+static void
+delay (void)
+{
+  volatile int i;
+
+  for (i = 0; i < 100000; i++)
+    continue;
+}
+
+void
+test_main (void)
+{
+  volatile int stack_var = 3;
+  pid_t pid;
+
+  bss_var = 2;
+  pid = fork ();
+  if (pid == 0)
+    {
+      delay ();
+      if (data_var != 1 || bss_var != 2 || stack_var != 3)
+        fail ("child sees the parent's writes");
+      data_var = 10;
+      bss_var = 20;
+      stack_var = 30;
+      exit (0);
+    }
+  if (pid == PID_ERROR)
+    fail ("fork");
+  data_var = 100;
+  bss_var = 200;
+  stack_var = 300;
+  CHECK (wait (pid) == 0, "wait for child");
+  CHECK (data_var == 100 && bss_var == 200 && stack_var == 300,
+         "parent does not see the child's writes");
+}
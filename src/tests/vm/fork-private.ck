@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-private) begin
+fork-private: exit(0)
+(fork-private) wait for child
+(fork-private) parent does not see the child's writes
+(fork-private) end
+fork-private: exit(0)
+EOF
+pass;
@@ -0,0 +1,22 @@
+/* Forks a child, which sees 0 from fork() and exits with a status
+   that the parent collects by waiting on the pid that it got. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  pid_t pid = fork ();
+
+  if (pid == 0)
+    {
+      msg ("child sees 0 from fork");
+      exit (81);
+    }
+  if (pid == PID_ERROR)
+    fail ("fork");
+  CHECK (wait (pid) == 81, "wait for child");
+  CHECK (wait (pid) == -1, "wait for child a second time (must fail)");
+}
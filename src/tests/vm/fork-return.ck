@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-return) begin
+(fork-return) child sees 0 from fork
+fork-return: exit(81)
+(fork-return) wait for child
+(fork-return) wait for child a second time (must fail)
+(fork-return) end
+fork-return: exit(0)
+EOF
+pass;
@@ -0,0 +1,55 @@
+/* Fills 2 MB of memory and forks.  The child rewrites all of it,
+   so that the two copies together do not fit in memory and must
+   be paged out to swap, and each process then checks that it
+   still sees its own data. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/arc4.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (2 * 1024 * 1024)
+
+static char buf[SIZE];
+
+/* Fails unless all of BUF is zero.  WHO names the process. */
+static void
+check_zero (const char *who)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != 0)
+      fail ("%s's byte %zu != 0", who, i);
+}
+
+void
+test_main (void)
+{
+  struct arc4 arc4;
+  pid_t pid;
+
+  /* Encrypt zeros. */
+  msg ("initialize");
+  arc4_init (&arc4, "foobar", 6);
+  arc4_crypt (&arc4, buf, SIZE);
+
+  pid = fork ();
+  if (pid == 0)
+    {
+      /* Decrypt back to zeros, writing every page. */
+      arc4_init (&arc4, "foobar", 6);
+      arc4_crypt (&arc4, buf, SIZE);
+      check_zero ("child");
+      exit (0);
+    }
+  if (pid == PID_ERROR)
+    fail ("fork");
+  CHECK (wait (pid) == 0, "wait for child");
+
+  msg ("read pass");
+  arc4_init (&arc4, "foobar", 6);
+  arc4_crypt (&arc4, buf, SIZE);
+  check_zero ("parent");
+}
@@ -0,0 +1,58 @@
+/* Reads a BSS page, which maps it to the frame of zeros that all
+   processes share, and then checks that writing it after fork()
+   changes neither the other process's page nor the zeros seen
+   through other untouched pages. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+
+static char buf[PAGE_SIZE * 4];
+
+/* Returns true if the SIZE bytes at P are all zero. */
+static bool
+is_zero (const char *p, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    if (p[i] != 0)
+      return false;
+  return true;
+}
+
+void
+test_main (void)
+{
+  char *page = (char *) (((uintptr_t) buf + PAGE_SIZE - 1)
+                         & ~(uintptr_t) (PAGE_SIZE - 1));
+  pid_t pid;
+
+  CHECK (is_zero (page, PAGE_SIZE), "read BSS page");
+  pid = fork ();
+  if (pid == 0)
+    {
+      memset (page, 'c', PAGE_SIZE);
+      if (!is_zero (page + PAGE_SIZE, PAGE_SIZE))
+        fail ("child's untouched page is not zero");
+      exit (0);
+    }
+  if (pid == PID_ERROR)
+    fail ("fork");
+  CHECK (wait (pid) == 0, "wait for child");
+  CHECK (is_zero (page, PAGE_SIZE), "parent's page is still zero");
+
+  pid = fork ();
+  if (pid == 0)
+    exit (is_zero (page, PAGE_SIZE) ? 0 : 1);
+  if (pid == PID_ERROR)
+    fail ("fork");
+  memset (page, 'p', PAGE_SIZE);
+  CHECK (wait (pid) == 0, "wait for second child");
+  CHECK (is_zero (page + 2 * PAGE_SIZE, PAGE_SIZE),
+         "untouched page is still zero");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-zero) begin
+(fork-zero) read BSS page
+fork-zero: exit(0)
+(fork-zero) wait for child
+(fork-zero) parent's page is still zero
+fork-zero: exit(0)
+(fork-zero) wait for second child
+(fork-zero) untouched page is still zero
+(fork-zero) end
+fork-zero: exit(0)
+EOF
+pass;
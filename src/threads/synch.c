@@ -336,3 +336,233 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes RW.  A reader/writer lock can be held by any number
+   of readers at once, or by a single writer.  It prefers writers:
+   once a writer is waiting, new readers wait too, so a steady
+   stream of readers cannot starve writers.  Like locks, reader/
+   writer locks are not recursive; in particular, a reader that
+   tries to acquire RW for reading again may wait forever behind
+   a waiting writer. */
+void
+rw_init (struct rwlock *rw) 
+{
+  ASSERT (rw != NULL);
+
+  lock_init (&rw->lock);
+  cond_init (&rw->readers_ok);
+  cond_init (&rw->writers_ok);
+  cond_init (&rw->upgrade_ok);
+  rw->readers = 0;
+  rw->waiting_writers = 0;
+  rw->writer = NULL;
+  rw->upgrading = false;
+}
+
+/* Acquires RW for reading, sleeping while it is held or wanted
+   by a writer, including a reader that is upgrading.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_read_acquire (struct rwlock *rw) 
+{
+  ASSERT (rw != NULL);
+  ASSERT (!rw_write_held_by_current_thread (rw));
+
+  lock_acquire (&rw->lock);
+  while (rw->writer != NULL || rw->waiting_writers > 0 || rw->upgrading)
+    cond_wait (&rw->readers_ok, &rw->lock);
+  rw->readers++;
+  lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread holds for reading. */
+void
+rw_read_release (struct rwlock *rw) 
+{
+  ASSERT (rw != NULL);
+
+  lock_acquire (&rw->lock);
+  ASSERT (rw->readers > 0);
+  if (--rw->readers == 0)
+    cond_signal (&rw->writers_ok, &rw->lock);
+  else if (rw->readers == 1 && rw->upgrading)
+    cond_signal (&rw->upgrade_ok, &rw->lock);
+  lock_release (&rw->lock);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_write_acquire (struct rwlock *rw) 
+{
+  ASSERT (rw != NULL);
+  ASSERT (!rw_write_held_by_current_thread (rw));
+
+  lock_acquire (&rw->lock);
+  rw->waiting_writers++;
+  while (rw->writer != NULL || rw->readers > 0 || rw->upgrading)
+    cond_wait (&rw->writers_ok, &rw->lock);
+  rw->waiting_writers--;
+  rw->writer = thread_current ();
+  lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread holds for writing.  Hands
+   RW to a waiting writer if there is one, otherwise to all the
+   waiting readers. */
+void
+rw_write_release (struct rwlock *rw) 
+{
+  ASSERT (rw != NULL);
+  ASSERT (rw_write_held_by_current_thread (rw));
+
+  lock_acquire (&rw->lock);
+  rw->writer = NULL;
+  if (rw->waiting_writers > 0)
+    cond_signal (&rw->writers_ok, &rw->lock);
+  else
+    cond_broadcast (&rw->readers_ok, &rw->lock);
+  lock_release (&rw->lock);
+}
+
+/* Converts the current thread's read hold on RW into a write
+   hold, waiting for the other readers to leave.  No writer can
+   get in first, so whatever the caller read stays valid.
+
+   Returns false, without waiting, if another reader is already
+   upgrading.  The caller then still holds RW for reading, and
+   must release it, or both upgrades would wait forever. */
+bool
+rw_upgrade (struct rwlock *rw) 
+{
+  ASSERT (rw != NULL);
+
+  lock_acquire (&rw->lock);
+  ASSERT (rw->readers > 0);
+  if (rw->upgrading) 
+    {
+      lock_release (&rw->lock);
+      return false;
+    }
+  rw->upgrading = true;
+  while (rw->readers > 1)
+    cond_wait (&rw->upgrade_ok, &rw->lock);
+  rw->readers--;
+  rw->upgrading = false;
+  rw->writer = thread_current ();
+  lock_release (&rw->lock);
+  return true;
+}
+
+/* Converts the current thread's write hold on RW into a read
+   hold, without letting any writer in between.  Waiting readers
+   may enter too, unless a writer is waiting. */
+void
+rw_downgrade (struct rwlock *rw) 
+{
+  ASSERT (rw != NULL);
+  ASSERT (rw_write_held_by_current_thread (rw));
+
+  lock_acquire (&rw->lock);
+  rw->writer = NULL;
+  rw->readers++;
+  if (rw->waiting_writers == 0)
+    cond_broadcast (&rw->readers_ok, &rw->lock);
+  lock_release (&rw->lock);
+}
+
+/* Returns true if the current thread holds RW for writing, false
+   otherwise. */
+bool
+rw_write_held_by_current_thread (const struct rwlock *rw) 
+{
+  ASSERT (rw != NULL);
+
+  return rw->writer == thread_current ();
+}
+
+/* State shared by rw_self_test() and its helper threads. */
+struct rw_test 
+  {
+    struct rwlock rw;
+    struct semaphore done;      /* Upped by each helper as it exits. */
+    char order[2];              /* Helpers that got in, in order. */
+    int order_cnt;
+  };
+
+static void rw_test_reader (void *);
+static void rw_test_writer (void *);
+
+/* Self-test for reader/writer locks.  Checks that readers share
+   the lock, that a waiting writer goes ahead of readers that
+   arrive after it, and that upgrading and downgrading work. */
+void
+rw_self_test (void) 
+{
+  struct rw_test t;
+  int i;
+
+  printf ("Testing reader/writer locks...");
+  rw_init (&t.rw);
+  sema_init (&t.done, 0);
+  t.order_cnt = 0;
+
+  /* A reader gets in while we hold the lock for reading. */
+  rw_read_acquire (&t.rw);
+  thread_create ("rw-reader", PRI_DEFAULT, rw_test_reader, &t);
+  sema_down (&t.done);
+  ASSERT (t.order_cnt == 1);
+
+  /* A writer queues up, and a reader that comes later waits
+     behind it. */
+  t.order_cnt = 0;
+  thread_create ("rw-writer", PRI_DEFAULT, rw_test_writer, &t);
+  while (t.rw.waiting_writers == 0)
+    thread_yield ();
+  thread_create ("rw-reader", PRI_DEFAULT, rw_test_reader, &t);
+  for (i = 0; i < 10; i++)
+    thread_yield ();
+  ASSERT (t.order_cnt == 0);
+  rw_read_release (&t.rw);
+  sema_down (&t.done);
+  sema_down (&t.done);
+  ASSERT (t.order_cnt == 2 && t.order[0] == 'w' && t.order[1] == 'r');
+
+  /* Upgrade and downgrade. */
+  rw_read_acquire (&t.rw);
+  ASSERT (rw_upgrade (&t.rw));
+  ASSERT (rw_write_held_by_current_thread (&t.rw));
+  rw_downgrade (&t.rw);
+  ASSERT (!rw_write_held_by_current_thread (&t.rw));
+  rw_read_release (&t.rw);
+  printf ("done.\n");
+}
+
+/* Reader thread function used by rw_self_test(). */
+static void
+rw_test_reader (void *t_) 
+{
+  struct rw_test *t = t_;
+
+  rw_read_acquire (&t->rw);
+  t->order[t->order_cnt++] = 'r';
+  rw_read_release (&t->rw);
+  sema_up (&t->done);
+}
+
+/* Writer thread function used by rw_self_test(). */
+static void
+rw_test_writer (void *t_) 
+{
+  struct rw_test *t = t_;
+
+  rw_write_acquire (&t->rw);
+  t->order[t->order_cnt++] = 'w';
+  rw_write_release (&t->rw);
+  sema_up (&t->done);
+}
@@ -41,6 +41,29 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader/writer lock. */
+struct rwlock 
+  {
+    struct lock lock;           /* Guards the members below. */
+    struct condition readers_ok;  /* Signaled when readers may enter. */
+    struct condition writers_ok;  /* Signaled when a writer may enter. */
+    struct condition upgrade_ok;  /* Signaled when an upgrade may finish. */
+    unsigned readers;           /* Number of threads reading. */
+    unsigned waiting_writers;   /* Number of threads waiting to write. */
+    struct thread *writer;      /* Thread writing, or null. */
+    bool upgrading;             /* Is a reader waiting to upgrade? */
+  };
+
+void rw_init (struct rwlock *);
+void rw_read_acquire (struct rwlock *);
+void rw_read_release (struct rwlock *);
+void rw_write_acquire (struct rwlock *);
+void rw_write_release (struct rwlock *);
+bool rw_upgrade (struct rwlock *);
+void rw_downgrade (struct rwlock *);
+bool rw_write_held_by_current_thread (const struct rwlock *);
+void rw_self_test (void);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
@@ -529,8 +529,12 @@ init_thread (struct thread *t, const char *name, int priority)
   t->stack = (uint8_t *) t + PGSIZE;
   t->priority = priority;
   t->magic = THREAD_MAGIC;
-  list_init(&(t -> fd_entries));
-  t -> total_fd = 2;
+  t -> fd_table = NULL;
+  t -> fd_cnt = 0;
+  t -> fd_next = 2;
+#ifdef VM
+  list_init (&t->mappings);
+#endif
   old_level = intr_disable ();
   list_push_back (&all_list, &t->allelem);
   sema_init(&(t->child_load_sema), 0);
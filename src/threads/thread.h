@@ -2,6 +2,7 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <hash.h>
 #include <list.h>
 #include <stdint.h>
 #include "threads/synch.h"
@@ -116,20 +117,30 @@ struct thread
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
 #endif
+#ifdef VM
+    /* Owned by vm/page.c and vm/mmap.c. */
+    struct hash pages;                  /* Supplemental page table. */
+    bool has_pages;                     /* PAGES is initialized. */
+    struct list mappings;               /* Memory-mapped files. */
+    int next_mapid;                     /* Next mapping identifier. */
+    void *user_esp;                     /* Stack pointer at syscall. */
+#endif
 
     /* Owned by thread.c. */
     unsigned magic;                     /* Detects stack overflow. */
 
-   // next fd
-   int total_fd;
-   struct list fd_entries;
+   // open files, indexed by fd
+   struct file_record **fd_table;
+   // number of slots in fd_table
+   int fd_cnt;
+   // every fd below this one is in use
+   int fd_next;
   };
 
 struct file_record
 {
  struct dir *dir;
  struct file *cfile;
- struct list_elem elem;
  int fd;
 };
 
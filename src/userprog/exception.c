@@ -2,8 +2,13 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/syscall.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -150,6 +155,38 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
+#ifdef VM
+  /* Bring in a page that the process may use but that is not in
+     memory yet, or extend its stack down to the fault, then retry
+     the access.  A kernel fault on a user address happens during a
+     system call, so the stack pointer that counts is the one saved
+     on entry to it. */
+  if (not_present
+      && (page_fault_in (fault_addr, write)
+          || page_grow_stack (fault_addr, user ? f->esp
+                                               : thread_current ()->user_esp)))
+    return;
+
+  /* Give a process that writes a page it shares copy-on-write, with
+     a forked process or as the zero frame, its own copy, then retry
+     the write. */
+  if (!not_present && write && page_copy_on_write (fault_addr))
+    return;
+#endif
+
+  /* A kernel fault on a user address at the probe in get_user() or
+     put_user() means the system call was passed a bad pointer.
+     They leave the address to resume at in eax and expect -1 there
+     on failure.  Any other kernel fault is a kernel bug. */
+  if (!user && is_user_vaddr (fault_addr)
+      && ((const char *) f->eip == get_user_probe
+          || (const char *) f->eip == put_user_probe))
+    {
+      f->eip = (void (*) (void)) f->eax;
+      f->eax = 0xffffffff;
+      return;
+    }
+
   /* To implement virtual memory, delete the rest of the function
      body, and replace it with code that brings in the page to
      which fault_addr refers. */
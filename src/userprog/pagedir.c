@@ -8,6 +8,12 @@
 
 static uint32_t *active_pd (void);
 static void invalidate_pagedir (uint32_t *);
+static void invalidate_page (uint32_t *, const void *vpage);
+
+/* Longest range that pagedir_clear_range() invalidates page by
+   page.  Past this, one reload of CR3 costs less than the INVLPGs
+   plus the TLB misses they save. */
+#define INVLPG_MAX 32
 
 /* Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
@@ -152,10 +158,42 @@ pagedir_clear_page (uint32_t *pd, void *upage)
   if (pte != NULL && (*pte & PTE_P) != 0)
     {
       *pte &= ~PTE_P;
-      invalidate_pagedir (pd);
+      invalidate_page (pd, upage);
     }
 }
 
+/* Marks the PAGE_CNT user virtual pages starting at UPAGE "not
+   present" in page directory PD, as pagedir_clear_page() does for
+   each, but invalidates the TLB just once for a long range.  The
+   pages need not be mapped. */
+void
+pagedir_clear_range (uint32_t *pd, void *upage, size_t page_cnt)
+{
+  bool flush_all = page_cnt > INVLPG_MAX;
+  bool cleared = false;
+  uint8_t *p = upage;
+  size_t i;
+
+  ASSERT (pg_ofs (upage) == 0);
+
+  for (i = 0; i < page_cnt; i++, p += PGSIZE)
+    {
+      uint32_t *pte;
+
+      ASSERT (is_user_vaddr (p));
+      pte = lookup_page (pd, p, false);
+      if (pte != NULL && (*pte & PTE_P) != 0)
+        {
+          *pte &= ~PTE_P;
+          cleared = true;
+          if (!flush_all)
+            invalidate_page (pd, p);
+        }
+    }
+  if (flush_all && cleared)
+    invalidate_pagedir (pd);
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PD is dirty,
    that is, if the page has been modified since the PTE was
    installed.
@@ -180,7 +218,7 @@ pagedir_set_dirty (uint32_t *pd, const void *vpage, bool dirty)
       else 
         {
           *pte &= ~(uint32_t) PTE_D;
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -209,7 +247,7 @@ pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
       else 
         {
           *pte &= ~(uint32_t) PTE_A; 
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -261,3 +299,13 @@ invalidate_pagedir (uint32_t *pd)
       pagedir_activate (pd);
     } 
 }
+
+/* Invalidates the TLB entry for virtual page VPAGE if PD is the
+   active page directory, leaving the rest of the TLB alone.  See
+   [IA32-v2a] "INVLPG--Invalidate TLB Entry". */
+static void
+invalidate_page (uint32_t *pd, const void *vpage) 
+{
+  if (active_pd () == pd)
+    asm volatile ("invlpg %0" : : "m" (*(const char *) vpage) : "memory");
+}
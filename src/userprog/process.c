@@ -17,8 +17,21 @@
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "userprog/syscall.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
+
+/* Bytes at the start of an executable to prefetch into the buffer
+   cache on load: the headers and the first pages of text, without
+   crowding everything else out of the cache. */
+#define EXEC_PREFETCH_BYTES (16 * 1024)
 
 static thread_func start_process NO_RETURN;
+#ifdef VM
+static thread_func start_fork NO_RETURN;
+#endif
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
 
 /* Starts a new thread running a user program loaded from
@@ -94,6 +107,80 @@ start_process (void *file_name_)
   NOT_REACHED ();
 }
 
+#ifdef VM
+/* What process_fork() hands the new child. */
+struct fork_args
+  {
+    struct thread *parent;      /* Forking process. */
+    struct intr_frame if_;      /* Its registers at the fork. */
+  };
+
+/* Starts a new process that is a copy of the current one and
+   resumes from the system call whose interrupt frame is IF_.  The
+   child shares the parent's frames copy-on-write rather than
+   loading the executable again.  Returns the child's thread id once
+   the copy is done, or TID_ERROR if it cannot be made. */
+tid_t
+process_fork (const struct intr_frame *if_)
+{
+  struct thread *cur = thread_current ();
+  struct fork_args args;
+  tid_t tid;
+
+  args.parent = cur;
+  args.if_ = *if_;
+  tid = thread_create (cur->name, PRI_DEFAULT, start_fork, &args);
+  if (tid == TID_ERROR)
+    return TID_ERROR;
+  sema_down (&cur->child_load_sema);
+  return cur->child_status == -1 ? TID_ERROR : tid;
+}
+
+/* A thread function that copies the forking process into the new
+   one and starts it running, returning 0 from fork. */
+static void
+start_fork (void *args_)
+{
+  struct fork_args *args = args_;
+  struct thread *parent = args->parent;
+  struct thread *t = thread_current ();
+  struct intr_frame if_ = args->if_;
+  bool success;
+
+  /* The parent waits on CHILD_LOAD_SEMA below, so its address space
+     and fd table hold still while they are copied. */
+  t->exefile = file_reopen (parent->exefile);
+  if (t->exefile != NULL)
+    file_deny_write (t->exefile);
+  if (parent->cur_dir != NULL)
+    t->cur_dir = dir_reopen (parent->cur_dir);
+  t->pagedir = pagedir_create ();
+  success = (t->exefile != NULL && t->pagedir != NULL
+             && page_table_init ());
+  if (success)
+    {
+      process_activate ();
+      success = (page_table_copy (parent, t->exefile)
+                 && mmap_copy (parent)
+                 && fd_table_copy (parent));
+    }
+
+  parent->child_status = success ? 1 : -1;
+  sema_up (&parent->child_load_sema);
+  if (!success)
+    {
+      file_close (t->exefile);
+      dir_close (t->cur_dir);
+      thread_exit ();
+    }
+
+  /* Return to user mode as the parent did, but with 0 from fork. */
+  if_.eax = 0;
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+#endif
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
@@ -139,6 +226,15 @@ process_exit (void)
 {
   struct thread *cur = thread_current ();
   uint32_t *pd;
+#ifdef VM
+  /* Write back mapped files while the page directory still
+     records which pages are dirty.  A kernel thread has neither. */
+  if (cur->has_pages)
+    {
+      mmap_unmap_all ();
+      page_table_destroy ();
+    }
+#endif
   /* Destroy the current process's page directory and switch back
      tco the kernel-only page directory. */
   pd = cur->pagedir;
@@ -254,6 +350,7 @@ load (const char *file_name, void (**eip) (void), void **esp)
   struct file *file = NULL;
   off_t file_ofs;
   bool success = false;
+  char *temp_file_name = NULL;
   int i;
 
   /* Allocate and activate page directory. */
@@ -261,12 +358,16 @@ load (const char *file_name, void (**eip) (void), void **esp)
   if (t->pagedir == NULL) {
     goto done;
   }
+#ifdef VM
+  if (!page_table_init ())
+    goto done;
+#endif
   process_activate ();
 
   /* Open executable file. */
   // Create function name copy, so we can get the function name w/o args.
   char *save_ptr;
-  char *temp_file_name = malloc(strlen(file_name)+1);
+  temp_file_name = malloc(strlen(file_name)+1);
   if (temp_file_name == NULL)
     return false;
   strlcpy(temp_file_name, file_name, strlen(file_name)+1);
@@ -280,6 +381,9 @@ load (const char *file_name, void (**eip) (void), void **esp)
     }
    t -> exefile = file;
    file_deny_write(t -> exefile);
+  /* Let the disk fetch the headers and text while the page table
+     and stack are set up. */
+  file_prefetch (file, EXEC_PREFETCH_BYTES);
   /* Read and verify executable header. */
   if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
       || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
@@ -372,7 +476,9 @@ load (const char *file_name, void (**eip) (void), void **esp)
 }
 /* load() helpers. */
 
+#ifndef VM
 static bool install_page (void *upage, void *kpage, bool writable);
+#endif
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -432,7 +538,11 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
    user process if WRITABLE is true, read-only otherwise.
 
    Return true if successful, false if a memory allocation error
-   or disk read error occurs. */
+   or disk read error occurs.
+
+   With VM, the pages are only recorded in the supplemental page
+   table here.  Each is read or zeroed by the page fault handler
+   the first time the process touches it. */
 static bool
 load_segment (struct file *file, off_t ofs, uint8_t *upage,
               uint32_t read_bytes, uint32_t zero_bytes, bool writable) 
@@ -441,6 +551,23 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
+#ifdef VM
+  while (read_bytes > 0 || zero_bytes > 0) 
+    {
+      size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
+      size_t page_zero_bytes = PGSIZE - page_read_bytes;
+
+      if (page_add_file (upage, file, ofs, page_read_bytes, writable,
+                         false) == NULL)
+        return false;
+
+      read_bytes -= page_read_bytes;
+      zero_bytes -= page_zero_bytes;
+      ofs += page_read_bytes;
+      upage += PGSIZE;
+    }
+  return true;
+#else
   file_seek (file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) 
     {
@@ -476,6 +603,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       upage += PGSIZE;
     }
   return true;
+#endif
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
@@ -483,64 +611,72 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 static bool
 setup_stack (void **esp, const char* file_name) 
 {
-  uint8_t *kpage;
+  uint8_t *upage = ((uint8_t *) PHYS_BASE) - PGSIZE;
   bool success = false;
 
-  kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+#ifdef VM
+  /* The stack page is anonymous memory that may be swapped out
+     like any other. */
+  success = (page_add_file (upage, NULL, 0, 0, true, false) != NULL
+             && page_fault_in (upage, true));
+#else
+  uint8_t *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
   if (kpage != NULL) 
     {
-      success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
-      if (success) {
-        *esp = PHYS_BASE;
-        //push filename and args on the stack
-        char *token, *save_ptr2;
-        int argsSize = 0;
-        int numArgs = 0;
-        for (token = strtok_r(file_name, " ", &save_ptr2); token != NULL;
-          token = strtok_r(NULL, " ", &save_ptr2)) 
-        {
-          int tokenSize = strlen(token) + 1;
-          if (argsSize + tokenSize > 4096) {
-            break;
-          }
-          *esp -= tokenSize;
-          strlcpy((char*)*esp, token, tokenSize);
-          argsSize += tokenSize;
-          numArgs++;
-        }
+      success = install_page (upage, kpage, true);
+      if (!success)
+        palloc_free_page (kpage);
+    }
+#endif
+  if (success) {
+    *esp = PHYS_BASE;
+    //push filename and args on the stack
+    char *token, *save_ptr2;
+    int argsSize = 0;
+    int numArgs = 0;
+    for (token = strtok_r(file_name, " ", &save_ptr2); token != NULL;
+      token = strtok_r(NULL, " ", &save_ptr2)) 
+    {
+      int tokenSize = strlen(token) + 1;
+      if (argsSize + tokenSize > 4096) {
+        break;
+      }
+      *esp -= tokenSize;
+      strlcpy((char*)*esp, token, tokenSize);
+      argsSize += tokenSize;
+      numArgs++;
+    }
 
-        // Temporary stack ptr to scan for addresses.
-        void* tempStackPtr = *esp;
+    // Temporary stack ptr to scan for addresses.
+    void* tempStackPtr = *esp;
 
-        // Round down stack pointer to multiple of 4.
-        *esp -= 4 - (argsSize % 4);
+    // Round down stack pointer to multiple of 4.
+    *esp -= 4 - (argsSize % 4);
 
-        *esp -= 4;
-        **(char***) esp = NULL;
-        int i; 
-        for (i = 0; i < numArgs; i++) {
-          *esp -= 4;
-          **(char***) esp = tempStackPtr;
-          tempStackPtr += strlen((char*) tempStackPtr) + 1;
-        }
+    *esp -= 4;
+    **(char***) esp = NULL;
+    int i; 
+    for (i = 0; i < numArgs; i++) {
+      *esp -= 4;
+      **(char***) esp = tempStackPtr;
+      tempStackPtr += strlen((char*) tempStackPtr) + 1;
+    }
 
-        tempStackPtr = *esp;
-        *esp -= 4;
-        **(char***) esp = tempStackPtr;
+    tempStackPtr = *esp;
+    *esp -= 4;
+    **(char***) esp = tempStackPtr;
 
-        *esp -= 4;
-        **(int**) esp = numArgs;
+    *esp -= 4;
+    **(int**) esp = numArgs;
 
-        *esp -= 4;
-        **(char***) esp = NULL;
-        }
-      } else {
-        palloc_free_page (kpage);
-      }
+    *esp -= 4;
+    **(char***) esp = NULL;
+  }
   
   return success;
 }
 
+#ifndef VM
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -560,3 +696,4 @@ install_page (void *upage, void *kpage, bool writable)
   return (pagedir_get_page (t->pagedir, upage) == NULL
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
+#endif
@@ -7,5 +7,9 @@ tid_t process_execute (const char *file_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
+#ifdef VM
+struct intr_frame;
+tid_t process_fork (const struct intr_frame *);
+#endif
 
 #endif /* userprog/process.h */
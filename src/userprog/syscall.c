@@ -1,8 +1,13 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
 #include <syscall-nr.h>
+#include <dirent.h>
+#include <stat.h>
+#include <uio.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/synch.h"
 #include "devices/shutdown.h"
 #include "filesys/off_t.h"
@@ -11,72 +16,295 @@
 #include "filesys/file.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
 
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
-#define USER_VADDR_BOUND (void*) 0x08048000
-
-struct lock filesys_mutex;
 
 static void syscall_handler (struct intr_frame *);
 
 static void parse_args(void* esp, int* argBuf, int numToParse);
-static void valid_ptr(void* user_ptr);
-static void valid_buf(char* buf, unsigned size);
-static void valid_string(void* string);
+static bool copy_from_user (void *dst, const void *usrc, size_t size);
+static bool copy_to_user (void *udst, const void *src, size_t size);
+static int strncpy_from_user (char *dst, const char *usrc, size_t size);
+static char *copy_in_string (const char *ustr);
+static void copy_out (void *udst, const void *src, size_t size);
+static void check_user_buf (void *ubuf, size_t size, bool writable);
+static void release_user_buf (void *ubuf, size_t size);
+static bool copy_in_iovec (struct iovec *iov, const struct iovec *uiov,
+                           int iov_cnt, bool writable);
 int inumber(int fd);
 bool isdir (int fd);
 bool readdir (int fd, char *name);
+int getdents (int fd, struct dirent *ents, unsigned cnt);
+bool stat (const char *filename, struct stat *st);
+bool fstat (int fd, struct stat *st);
+static int open_at (struct dir *base, const char *file);
+int openat (int dirfd, const char *file);
+bool createat (int dirfd, const char *file, unsigned initial_size);
+bool mkdirat (int dirfd, const char *dir);
+bool unlinkat (int dirfd, const char *file);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int readv (int fd, const struct iovec *iov, int iov_cnt);
+int writev (int fd, const struct iovec *iov, int iov_cnt);
+int copy_file_range (int in_fd, int out_fd, unsigned length);
+#ifdef VM
+mapid_t mmap (int fd, void *addr);
+void munmap (mapid_t mapping);
+#endif
 bool mkdir (const char *filename);
 bool chdir (const char *filename);
 struct file_record * fileRd_ptr(int fd);
-
-
-
-
-
-static int
+static int fd_install (struct file_record *);
+static void fd_release (struct file_record *);
+static void fd_table_close (struct thread *);
+/* Reads a byte at user virtual address UADDR.
+   UADDR must be below PHYS_BASE.
+   Returns the byte value if successful, -1 if a segfault
+   occurred.  Never inlined, so that get_user_probe labels a
+   single instruction. */
+static int NO_INLINE
 get_user (const uint8_t *uaddr)
 {
   int result;
-  asm ("movl $1f, %0; movzbl %1, %0; 1:"
+  asm ("movl $1f, %0; .globl get_user_probe; get_user_probe: "
+       "movzbl %1, %0; 1:"
        : "=&a" (result) : "m" (*uaddr));
   return result;
 }
 
 /* Writes BYTE to user address UDST.
    UDST must be below PHYS_BASE.
-   Returns true if successful, false if a segfault occurred. */
-static bool
+   Returns true if successful, false if a segfault occurred.
+   Never inlined, so that put_user_probe labels a single
+   instruction. */
+static bool NO_INLINE
 put_user (uint8_t *udst, uint8_t byte)
 {
   int error_code;
-  asm ("movl $1f, %0; movb %b2, %1; 1:"
+  asm ("movl $1f, %0; .globl put_user_probe; put_user_probe: "
+       "movb %b2, %1; 1:"
        : "=&a" (error_code), "=m" (*udst) : "q" (byte));
   return error_code != -1;
 }
 
+/* Returns true if the SIZE bytes starting at UADDR all lie in
+   user virtual memory. */
+static bool
+user_range_ok (const void *uaddr, size_t size)
+{
+  return is_user_vaddr (uaddr)
+         && size <= (size_t) ((const uint8_t *) PHYS_BASE
+                              - (const uint8_t *) uaddr);
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address DST.
+   Each user page is touched once through get_user(), so an
+   unmapped page is caught by the page fault handler instead of a
+   page table walk per byte.  Returns true if successful, false if
+   USRC is not all mapped user memory. */
+static bool
+copy_from_user (void *dst_, const void *usrc_, size_t size)
+{
+  uint8_t *dst = dst_;
+  const uint8_t *usrc = usrc_;
+
+  if (!user_range_ok (usrc, size))
+    return false;
+  while (size > 0)
+    {
+      size_t chunk = PGSIZE - pg_ofs (usrc);
+      if (chunk > size)
+        chunk = size;
+      if (get_user (usrc) == -1)
+        return false;
+      memcpy (dst, usrc, chunk);
+      dst += chunk;
+      usrc += chunk;
+      size -= chunk;
+    }
+  return true;
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address UDST,
+   probing each user page once with put_user().  Returns true if
+   successful, false if UDST is not all writable user memory. */
+static bool
+copy_to_user (void *udst_, const void *src_, size_t size)
+{
+  uint8_t *udst = udst_;
+  const uint8_t *src = src_;
+
+  if (!user_range_ok (udst, size))
+    return false;
+  while (size > 0)
+    {
+      size_t chunk = PGSIZE - pg_ofs (udst);
+      if (chunk > size)
+        chunk = size;
+      if (!put_user (udst, *src))
+        return false;
+      memcpy (udst + 1, src + 1, chunk - 1);
+      udst += chunk;
+      src += chunk;
+      size -= chunk;
+    }
+  return true;
+}
+
+/* Copies the null-terminated string at user address USRC into DST,
+   which has room for SIZE bytes.  Returns the length of the string,
+   or -1 if it is not in mapped user memory or is not terminated
+   within SIZE bytes. */
+static int
+strncpy_from_user (char *dst, const char *usrc, size_t size)
+{
+  size_t len = 0;
+
+  while (len < size)
+    {
+      const char *p = usrc + len;
+      size_t chunk, i;
+
+      if (!is_user_vaddr (p) || get_user ((const uint8_t *) p) == -1)
+        return -1;
+      chunk = PGSIZE - pg_ofs (p);
+      if (chunk > size - len)
+        chunk = size - len;
+      for (i = 0; i < chunk; i++, len++)
+        if ((dst[len] = p[i]) == '\0')
+          return len;
+    }
+  return -1;
+}
+
+/* Returns a copy of user string USTR in a new page, which the
+   caller must free with palloc_free_page().  Kills the process if
+   USTR is bad. */
+static char *
+copy_in_string (const char *ustr)
+{
+  char *kstr = palloc_get_page (0);
+  if (kstr == NULL || strncpy_from_user (kstr, ustr, PGSIZE) == -1)
+    {
+      palloc_free_page (kstr);
+      exit (-1);
+    }
+  return kstr;
+}
 
+/* Copies SIZE bytes from SRC to user address UDST, killing the
+   process if UDST is bad. */
+static void
+copy_out (void *udst, const void *src, size_t size)
+{
+  if (!copy_to_user (udst, src, size))
+    exit (-1);
+}
 
+/* Kills the process unless the SIZE bytes at UBUF are mapped user
+   memory, and also writable if WRITABLE is true.  Checks one byte
+   per page; file I/O then goes to UBUF directly.  With VM, each
+   page is also pinned in memory, so that the I/O cannot fault
+   while it holds file system locks, until release_user_buf(). */
+static void
+check_user_buf (void *ubuf, size_t size, bool writable)
+{
+  uint8_t *p = ubuf;
 
+  if (!user_range_ok (ubuf, size))
+    exit (-1);
+  while (size > 0)
+    {
+      size_t chunk = PGSIZE - pg_ofs (p);
+      int byte = get_user (p);
+      if (byte == -1 || (writable && !put_user (p, byte)))
+        exit (-1);
+#ifdef VM
+      if (!page_pin (p))
+        exit (-1);
+#endif
+      if (chunk > size)
+        chunk = size;
+      p += chunk;
+      size -= chunk;
+    }
+}
 
+/* Releases the SIZE bytes at UBUF, checked by check_user_buf(),
+   once the I/O to them is done. */
+static void
+release_user_buf (void *ubuf UNUSED, size_t size UNUSED)
+{
+#ifdef VM
+  uint8_t *p = ubuf;
 
+  while (size > 0)
+    {
+      size_t chunk = PGSIZE - pg_ofs (p);
+      page_unpin (p);
+      if (chunk > size)
+        chunk = size;
+      p += chunk;
+      size -= chunk;
+    }
+#endif
+}
+
+/* Copies the IOV_CNT-element iovec array at user address UIOV into
+   IOV, which has room for IOV_MAX elements, and checks each buffer
+   it names as check_user_buf() does.  Returns false if IOV_CNT is
+   out of range or the buffers total more than a file can hold.
+   Kills the process if any of the memory is bad. */
+static bool
+copy_in_iovec (struct iovec *iov, const struct iovec *uiov, int iov_cnt,
+               bool writable)
+{
+  size_t total = 0;
+  int i;
+
+  if (iov_cnt < 0 || iov_cnt > IOV_MAX)
+    return false;
+  if (!copy_from_user (iov, uiov, iov_cnt * sizeof *iov))
+    exit (-1);
+  for (i = 0; i < iov_cnt; i++)
+    {
+      if (iov[i].iov_len > (size_t) INT32_MAX - total)
+        return false;
+      total += iov[i].iov_len;
+    }
+  for (i = 0; i < iov_cnt; i++)
+    check_user_buf (iov[i].iov_base, iov[i].iov_len, writable);
+  return true;
+}
 
 void
 syscall_init (void) 
 {
-  lock_init(&filesys_mutex);
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
 }
 
 static void
 syscall_handler (struct intr_frame *f) 
 {
-  int args[3];
+  int args[4];
   void* esp = f->esp;
-  valid_ptr(esp);
-  uint32_t current_syscall = *(uint32_t*)esp;
+  uint32_t current_syscall;
+  char *name;
+  struct stat st;
+
+#ifdef VM
+  /* Lets the page fault handler grow the stack down to a buffer
+     that the system call touches. */
+  thread_current ()->user_esp = esp;
+#endif
+  if (!copy_from_user (&current_syscall, esp, sizeof current_syscall))
+    exit (-1);
   
   switch(current_syscall)
   {
@@ -89,9 +317,9 @@ syscall_handler (struct intr_frame *f)
 		break;
 	case SYS_EXEC:
 		parse_args(esp, &args[0], 1);
-    valid_ptr(args[0]);
-    valid_string((void*) args[0]);
-    f->eax = exec ((const char*) args[0]);
+    name = copy_in_string ((const char *) args[0]);
+    f->eax = exec (name);
+    palloc_free_page (name);
 		break;
 	case SYS_WAIT:
 		parse_args(esp, &args[0], 1);
@@ -99,22 +327,21 @@ syscall_handler (struct intr_frame *f)
 		break;
   case SYS_CREATE:
 		parse_args(esp, &args[0], 2);
-    valid_ptr(args[0]);
-    //valid_buf((char*)args[0], (unsigned)args[1]);
-    valid_string((void*) args[0]);
-    f->eax = create((const char*) args[0], (unsigned) args[1]);
+    name = copy_in_string ((const char *) args[0]);
+    f->eax = create(name, (unsigned) args[1]);
+    palloc_free_page (name);
     break;
 	case SYS_REMOVE:
 		parse_args(esp, &args[0], 1);
-    valid_ptr(args[0]);
-    valid_string((void*) args[0]);
-    f->eax = remove ((const char*) args[0]);
+    name = copy_in_string ((const char *) args[0]);
+    f->eax = remove (name);
+    palloc_free_page (name);
 		break;
 	case SYS_OPEN:
 		parse_args(esp, &args[0], 1);
-    valid_ptr(args[0]);
-    valid_string((void*) args[0]);
-    f->eax = open ((const char*) args[0]);
+    name = copy_in_string ((const char *) args[0]);
+    f->eax = open (name);
+    palloc_free_page (name);
 		break;
 	case SYS_FILESIZE:
 		parse_args(esp, &args[0], 1);
@@ -122,15 +349,15 @@ syscall_handler (struct intr_frame *f)
 		break;
 	case SYS_READ:
 		parse_args(esp, &args[0], 3);
-    valid_ptr(args[1]);
-    valid_buf((char*) args[1], (unsigned)args[2]);
+    check_user_buf ((void *) args[1], (unsigned) args[2], true);
     f->eax = read ((int) args[0], (void*) args[1], (unsigned) args[2]);
+    release_user_buf ((void *) args[1], (unsigned) args[2]);
 		break;
 	case SYS_WRITE:
 		parse_args(esp, &args[0], 3);
-    valid_ptr(args[1]);
-    valid_buf((char*) args[1], (unsigned) args[2]);
+    check_user_buf ((void *) args[1], (unsigned) args[2], false);
 	  f->eax = write((int) args[0], (const void*) args[1], (unsigned) args[2]);
+    release_user_buf ((void *) args[1], (unsigned) args[2]);
 		break;
 	case SYS_SEEK:
 		parse_args(esp, &args[0], 2);
@@ -146,11 +373,19 @@ syscall_handler (struct intr_frame *f)
 		break;
 	case SYS_CHDIR:
 		parse_args (esp, &args [0], 1);
-		f->eax = chdir ((const char *) args[0]);
+		name = copy_in_string ((const char *) args[0]);
+		f->eax = chdir (name);
+		palloc_free_page (name);
 		break;
 	case SYS_READDIR:
-		parse_args (esp, &args[0], 2);
-		f->eax = readdir ((int) args[0], (char *) args[1]);
+		{
+			char entry[NAME_MAX + 1];
+
+			parse_args (esp, &args[0], 2);
+			f->eax = readdir ((int) args[0], entry);
+			if (f->eax)
+				copy_out ((char *) args[1], entry, strlen (entry) + 1);
+		}
 		break;
 	case SYS_ISDIR:
 		parse_args (esp, &args[0], 1);
@@ -162,8 +397,114 @@ syscall_handler (struct intr_frame *f)
 		break;
 	case SYS_MKDIR:
 		parse_args (esp, &args[0], 1);
-		f->eax = mkdir ((const char *)args[0]);
+		name = copy_in_string ((const char *) args[0]);
+		f->eax = mkdir (name);
+		palloc_free_page (name);
+		break;
+	case SYS_GETDENTS:
+		parse_args (esp, &args[0], 3);
+		if ((unsigned) args[2] > (unsigned) PHYS_BASE / sizeof (struct dirent))
+			exit (-1);
+		check_user_buf ((void *) args[1],
+		                (unsigned) args[2] * sizeof (struct dirent), true);
+		f->eax = getdents ((int) args[0], (struct dirent *) args[1],
+		                   (unsigned) args[2]);
+		release_user_buf ((void *) args[1],
+		                  (unsigned) args[2] * sizeof (struct dirent));
+		break;
+	case SYS_STAT:
+		parse_args (esp, &args[0], 2);
+		name = copy_in_string ((const char *) args[0]);
+		f->eax = stat (name, &st);
+		palloc_free_page (name);
+		if (f->eax)
+			copy_out ((void *) args[1], &st, sizeof st);
+		break;
+	case SYS_FSTAT:
+		parse_args (esp, &args[0], 2);
+		f->eax = fstat ((int) args[0], &st);
+		if (f->eax)
+			copy_out ((void *) args[1], &st, sizeof st);
+		break;
+	case SYS_OPENAT:
+		parse_args (esp, &args[0], 2);
+		name = copy_in_string ((const char *) args[1]);
+		f->eax = openat ((int) args[0], name);
+		palloc_free_page (name);
+		break;
+	case SYS_CREATEAT:
+		parse_args (esp, &args[0], 3);
+		name = copy_in_string ((const char *) args[1]);
+		f->eax = createat ((int) args[0], name, (unsigned) args[2]);
+		palloc_free_page (name);
 		break;
+	case SYS_MKDIRAT:
+		parse_args (esp, &args[0], 2);
+		name = copy_in_string ((const char *) args[1]);
+		f->eax = mkdirat ((int) args[0], name);
+		palloc_free_page (name);
+		break;
+	case SYS_UNLINKAT:
+		parse_args (esp, &args[0], 2);
+		name = copy_in_string ((const char *) args[1]);
+		f->eax = unlinkat ((int) args[0], name);
+		palloc_free_page (name);
+		break;
+	case SYS_PREAD:
+		parse_args (esp, &args[0], 4);
+		check_user_buf ((void *) args[1], (unsigned) args[2], true);
+		f->eax = pread ((int) args[0], (void *) args[1], (unsigned) args[2],
+		                (unsigned) args[3]);
+		release_user_buf ((void *) args[1], (unsigned) args[2]);
+		break;
+	case SYS_PWRITE:
+		parse_args (esp, &args[0], 4);
+		check_user_buf ((void *) args[1], (unsigned) args[2], false);
+		f->eax = pwrite ((int) args[0], (const void *) args[1],
+		                 (unsigned) args[2], (unsigned) args[3]);
+		release_user_buf ((void *) args[1], (unsigned) args[2]);
+		break;
+	case SYS_READV:
+	case SYS_WRITEV:
+		{
+			struct iovec iov[IOV_MAX];
+			bool is_read = current_syscall == SYS_READV;
+			int i;
+
+			parse_args (esp, &args[0], 3);
+			if (!copy_in_iovec (iov, (const struct iovec *) args[1], args[2],
+			                    is_read))
+			{
+				f->eax = -1;
+				break;
+			}
+			if (is_read)
+				f->eax = readv ((int) args[0], iov, args[2]);
+			else
+				f->eax = writev ((int) args[0], iov, args[2]);
+			for (i = 0; i < args[2]; i++)
+				release_user_buf (iov[i].iov_base, iov[i].iov_len);
+		}
+		break;
+	case SYS_COPY_FILE_RANGE:
+		parse_args (esp, &args[0], 3);
+		f->eax = copy_file_range ((int) args[0], (int) args[1],
+		                          (unsigned) args[2]);
+		break;
+#ifdef VM
+	case SYS_MMAP:
+		parse_args (esp, &args[0], 2);
+		f->eax = mmap ((int) args[0], (void *) args[1]);
+		break;
+	case SYS_MUNMAP:
+		parse_args (esp, &args[0], 1);
+		munmap ((mapid_t) args[0]);
+		break;
+	case SYS_FORK:
+		/* The child sees 0, set by start_fork(). */
+		f->eax = process_fork (f);
+		break;
+#endif
 	default:	
     exit(-1);	
   }
@@ -173,20 +514,12 @@ syscall_handler (struct intr_frame *f)
 
 bool chdir (const char *filename)
 {
-	bool result;
-	lock_acquire (&filesys_mutex);
-	result = changeDir (filename);
-	lock_release (&filesys_mutex);
-	return result;
+	return changeDir (filename);
 }
 
 bool mkdir (const char *filename)
 {
-	bool result;
-	lock_acquire (&filesys_mutex);
-	result = filesys_create (filename, 0, true);
-	lock_release (&filesys_mutex);
-	return result;
+	return filesys_create (filename, 0, true);
 }
 
 bool readdir (int fd, char *name)
@@ -195,45 +528,103 @@ bool readdir (int fd, char *name)
 	struct file *file;
 	bool result;
 
-	lock_acquire (&filesys_mutex);
 	file_r = fileRd_ptr (fd);
 	if (file_r == NULL)
 	{
-		lock_release (&filesys_mutex);
 		return false;
 	}
 	file = file_r -> cfile;
 	struct inode *inode = file_get_inode (file);
 	if (inode == NULL)
 	{
-		lock_release (&filesys_mutex);
 		return false;
 	}
 	if (! inode_is_dir(inode))
 	{
-		lock_release (&filesys_mutex);
 		return false;
 	}
 	result = dir_readdir(file_r->dir, name);
-	lock_release(&filesys_mutex);
 	return result;
 }
 
+/* Reads up to CNT entries from directory FD into ENTS, with each
+   entry's inode number and whether it is a directory.  Returns the
+   number of entries read, 0 at the end of the directory, or -1 if
+   FD is not an open directory. */
+int getdents (int fd, struct dirent *ents, unsigned cnt)
+{
+	struct file_record *file_r;
+	unsigned n = 0;
+
+	file_r = fileRd_ptr (fd);
+	if (file_r == NULL || file_r->dir == NULL)
+	{
+		return -1;
+	}
+	while (n < cnt)
+	{
+		block_sector_t sector;
+		struct inode *inode;
+
+		if (!dir_readdir_inumber (file_r->dir, ents[n].d_name, &sector))
+			break;
+		inode = inode_open (sector);
+		ents[n].d_ino = sector;
+		ents[n].d_isdir = inode != NULL && inode_is_dir (inode);
+		inode_close (inode);
+		n++;
+	}
+	return n;
+}
+
+/* Fills in *ST with the inode number, length, and type of INODE. */
+static void fill_stat (struct inode *inode, struct stat *st)
+{
+	st->st_ino = inode_get_inumber (inode);
+	st->st_size = inode_length (inode);
+	st->st_isdir = inode_is_dir (inode);
+}
+
+/* Fills in *ST for the file named FILENAME.  Returns true if
+   successful, false if the file cannot be opened. */
+bool stat (const char *filename, struct stat *st)
+{
+	struct file *file;
+
+	file = filesys_open (filename);
+	if (file != NULL)
+		fill_stat (file_get_inode (file), st);
+	file_close (file);
+	return file != NULL;
+}
+
+/* Fills in *ST for open file FD.  Returns true if successful,
+   false if FD is not open. */
+bool fstat (int fd, struct stat *st)
+{
+	struct file_record *file_r;
+
+	file_r = fileRd_ptr (fd);
+	if (file_r != NULL)
+		fill_stat (file_get_inode (file_r->cfile), st);
+	return file_r != NULL;
+}
+
 bool isdir (int fd)
 {
-	lock_acquire (&filesys_mutex);
 	struct file *file = file_ptr (fd);
+	if (file == NULL)
+		return false;
 	bool result = inode_is_dir (file_get_inode(file));
-	lock_release(&filesys_mutex);
 	return result;
 }
 
 int inumber(int fd)
 {
-	lock_acquire (&filesys_mutex);
 	struct file *file = file_ptr(fd);
+	if (file == NULL)
+		return -1;
 	int result = inode_get_inumber (file_get_inode(file));
-	lock_release(&filesys_mutex);
 	return result;
 }
 
@@ -270,13 +661,7 @@ void exit (int status)
       free(tempCR);
   }
 
-  templist = &(t->fd_entries);
-  while(!list_empty(templist)) {
-    struct list_elem *fd_elem = list_pop_front(templist);
-    struct file_record *tempFR = list_entry(fd_elem, struct file_record, elem);
-    file_close(tempFR->cfile);
-    free(tempFR);
-  }
+  fd_table_close (t);
   thread_exit ();
 }
 pid_t exec (const char *cmd_line) 
@@ -294,36 +679,32 @@ int wait (pid_t pid)
 }
 bool create (const char *file, unsigned initial_size) 
 {
-  lock_acquire(&filesys_mutex);
-  bool result = filesys_create(file, initial_size, false);
-  lock_release(&filesys_mutex);
-  return result;
+  return filesys_create(file, initial_size, false);
 }
 bool remove (const char *file) 
 {
-
-  lock_acquire(&filesys_mutex);
-  bool result = filesys_remove(file);
-  lock_release(&filesys_mutex);
-  return result;
+  return filesys_remove(file);
 }
 int open (const char *file) 
 {
-  
-  lock_acquire(&filesys_mutex);
+  return open_at (NULL, file);
+}
+
+/* Opens FILE, resolving a relative name from BASE or, if BASE is
+   null, from the current directory, and returns its new fd, or -1
+   on failure. */
+static int open_at (struct dir *base, const char *file)
+{
   struct file_record *cfileRecord;
   cfileRecord = malloc ( sizeof (struct file_record));
   if (cfileRecord == NULL) {
-    lock_release(&filesys_mutex);
     return -1;
   }
-  struct file *currentfile = filesys_open (file);
+  struct file *currentfile = filesys_open_at (base, file);
   if ( currentfile == NULL) {
     free(cfileRecord);
-    lock_release(&filesys_mutex);
     return -1;
   }
-  struct thread *t = thread_current();
   cfileRecord -> cfile = currentfile;
   //handle directory
   struct inode *inode = file_get_inode (cfileRecord -> cfile);
@@ -332,31 +713,161 @@ int open (const char *file)
 	  cfileRecord->dir = dir_open (inode_reopen(inode));
   }
   else cfileRecord->dir = NULL;
-  cfileRecord -> fd = t -> total_fd;
-  t -> total_fd = t -> total_fd + 1;
-  list_push_back(&(t-> fd_entries), &(cfileRecord ->elem));
-  int result = cfileRecord -> fd;
-  lock_release(&filesys_mutex);
+  if (fd_install (cfileRecord) == -1) {
+    fd_release (cfileRecord);
+    return -1;
+  }
+  return cfileRecord -> fd;
+}
+
+/* Gives RECORD the lowest free fd in the current thread's table,
+   growing the table if it is full.  Returns the fd, or -1 if
+   memory runs out. */
+static int fd_install (struct file_record *record)
+{
+  struct thread *t = thread_current ();
+  int fd = t->fd_next;
+
+  while (fd < t->fd_cnt && t->fd_table[fd] != NULL)
+    fd++;
+  if (fd == t->fd_cnt) {
+    int new_cnt = t->fd_cnt > 0 ? t->fd_cnt * 2 : 16;
+    struct file_record **new_table;
+
+    new_table = realloc (t->fd_table, new_cnt * sizeof *new_table);
+    if (new_table == NULL)
+      return -1;
+    memset (new_table + t->fd_cnt, 0,
+            (new_cnt - t->fd_cnt) * sizeof *new_table);
+    t->fd_table = new_table;
+    t->fd_cnt = new_cnt;
+  }
+  t->fd_table[fd] = record;
+  t->fd_next = fd + 1;
+  record->fd = fd;
+  return fd;
+}
+
+/* Closes the file and directory in RECORD and frees it.  The caller
+   removes it from the fd table. */
+static void fd_release (struct file_record *record)
+{
+  dir_close (record->dir);
+  file_close (record->cfile);
+  free (record);
+}
+
+/* Closes every fd in T's table and frees the table. */
+static void fd_table_close (struct thread *t)
+{
+  int fd;
+  for (fd = 2; fd < t->fd_cnt; fd++) {
+    if (t->fd_table[fd] != NULL)
+      fd_release (t->fd_table[fd]);
+  }
+  free (t->fd_table);
+  t->fd_table = NULL;
+  t->fd_cnt = 0;
+}
+
+/* Gives the current thread, newly created by fork, a copy of
+   PARENT's fd table.  Each fd is open on the same file or directory
+   as in PARENT and starts at the same position, but moves on its
+   own from then on.  Returns false, with no fds open, if memory
+   runs out. */
+bool fd_table_copy (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  int fd;
+
+  if (parent->fd_cnt == 0)
+    return true;
+  t->fd_table = calloc (parent->fd_cnt, sizeof *t->fd_table);
+  if (t->fd_table == NULL)
+    return false;
+  t->fd_cnt = parent->fd_cnt;
+  t->fd_next = parent->fd_next;
+  for (fd = 2; fd < parent->fd_cnt; fd++) {
+    struct file_record *record = parent->fd_table[fd];
+    struct file_record *copy;
+    if (record == NULL)
+      continue;
+    copy = malloc (sizeof *copy);
+    if (copy == NULL) {
+      fd_table_close (t);
+      return false;
+    }
+    copy->cfile = file_reopen (record->cfile);
+    copy->dir = record->dir != NULL ? dir_reopen (record->dir) : NULL;
+    copy->fd = fd;
+    t->fd_table[fd] = copy;
+    if (copy->cfile == NULL || (record->dir != NULL && copy->dir == NULL)) {
+      fd_table_close (t);
+      return false;
+    }
+    file_seek (copy->cfile, file_tell (record->cfile));
+    if (copy->dir != NULL)
+      dir_seek (copy->dir, dir_tell (record->dir));
+  }
+  return true;
+}
+
+/* Returns the directory open as DIRFD, or a null pointer if DIRFD
+   is not an open directory. */
+static struct dir * dir_ptr (int dirfd)
+{
+  struct file_record *file_r = fileRd_ptr (dirfd);
+  return file_r != NULL ? file_r->dir : NULL;
+}
+
+int openat (int dirfd, const char *file)
+{
+  int result = -1;
+  struct dir *base = dir_ptr (dirfd);
+  if (base != NULL)
+    result = open_at (base, file);
+  return result;
+}
+
+bool createat (int dirfd, const char *file, unsigned initial_size)
+{
+  bool result = false;
+  struct dir *base = dir_ptr (dirfd);
+  if (base != NULL)
+    result = filesys_create_at (base, file, initial_size, false);
+  return result;
+}
+
+bool mkdirat (int dirfd, const char *dir)
+{
+  bool result = false;
+  struct dir *base = dir_ptr (dirfd);
+  if (base != NULL)
+    result = filesys_create_at (base, dir, 0, true);
+  return result;
+}
+
+bool unlinkat (int dirfd, const char *file)
+{
+  bool result = false;
+  struct dir *base = dir_ptr (dirfd);
+  if (base != NULL)
+    result = filesys_remove_at (base, file);
   return result;
 }
 int filesize (int fd) 
 {
-  lock_acquire(&filesys_mutex);
   struct file *tempfile;
   tempfile = file_ptr(fd);
   if (tempfile != NULL) {
     int result = file_length(tempfile);
-    lock_release(&filesys_mutex);
   	return result;
   }
-  lock_release(&filesys_mutex);
   return -1;
 }
 int read (int fd, void *buffer, unsigned length) 
 {
- lock_acquire(&filesys_mutex);
   if (fd == 1) {
-    lock_release(&filesys_mutex);
     return -1;
   }
  if (fd != 0)
@@ -364,11 +875,9 @@ int read (int fd, void *buffer, unsigned length)
    struct file *tempfile = NULL;
    tempfile = file_ptr(fd);
    if (tempfile == NULL) {
-      lock_release(&filesys_mutex);
  	    return -1;
    }
     int result = file_read (tempfile, buffer, length);
-    lock_release(&filesys_mutex);
     return result;
  }
  else{
@@ -377,15 +886,12 @@ int read (int fd, void *buffer, unsigned length)
  	    input_getc();
       bytesRead++;
     }
-    lock_release(&filesys_mutex);
     return bytesRead; 
 	}
 }
 int write (int fd, const void *buffer, unsigned length)
 {
-lock_acquire(&filesys_mutex);
   if (fd == 0) {
-    lock_release(&filesys_mutex);
     return -1;
   }
 if (fd != 1)
@@ -394,141 +900,183 @@ if (fd != 1)
   struct file *tempfile;
   tempfile = file_ptr(fd);
   if (tempfile == NULL) {
-    lock_release(&filesys_mutex);
     return -1;
   }
   if (inode_is_dir (file_get_inode(tempfile)))
   {
-    lock_release (&filesys_mutex);
     return -1;
   }
  	int result = file_write (tempfile, buffer, length);
-  lock_release(&filesys_mutex);
   return result;
  }
  else {
   putbuf(buffer, length);
-  lock_release(&filesys_mutex);
   return length;
  }
 
 }
+/* Reads up to LENGTH bytes from FD at byte OFFSET into BUFFER,
+   without using or moving FD's position.  No file extends past
+   INT32_MAX bytes, so LENGTH is cut short there.  Returns the
+   number of bytes read, or -1 if FD is not an open file. */
+int pread (int fd, void *buffer, unsigned length, unsigned offset)
+{
+  struct file *tempfile = file_ptr (fd);
+  if (tempfile == NULL || offset > INT32_MAX)
+    return -1;
+  if (length > INT32_MAX - offset)
+    length = INT32_MAX - offset;
+  return file_read_at (tempfile, buffer, length, offset);
+}
+
+/* Writes up to LENGTH bytes from BUFFER to FD at byte OFFSET,
+   without using or moving FD's position.  Returns the number of
+   bytes written, or -1 if FD is not an open ordinary file or the
+   write would end past INT32_MAX bytes. */
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset)
+{
+  struct file *tempfile = file_ptr (fd);
+  if (tempfile == NULL || offset > INT32_MAX
+      || length > INT32_MAX - offset
+      || inode_is_dir (file_get_inode (tempfile)))
+    return -1;
+  return file_write_at (tempfile, buffer, length, offset);
+}
+
+/* Reads from FD into the IOV_CNT buffers in IOV, in order.  Returns
+   the number of bytes read, or -1 if FD cannot be read. */
+int readv (int fd, const struct iovec *iov, int iov_cnt)
+{
+  struct file *tempfile;
+  int total = 0;
+  int i;
+
+  if (fd == 0) {
+    for (i = 0; i < iov_cnt; i++)
+      total += read (fd, iov[i].iov_base, iov[i].iov_len);
+    return total;
+  }
+  tempfile = file_ptr (fd);
+  if (tempfile == NULL)
+    return -1;
+  return file_readv (tempfile, iov, iov_cnt);
+}
+
+/* Writes the IOV_CNT buffers in IOV to FD, in order, as one write.
+   Returns the number of bytes written, or -1 if FD cannot be
+   written. */
+int writev (int fd, const struct iovec *iov, int iov_cnt)
+{
+  struct file *tempfile;
+  int total = 0;
+  int i;
+
+  if (fd == 1) {
+    for (i = 0; i < iov_cnt; i++) {
+      putbuf (iov[i].iov_base, iov[i].iov_len);
+      total += iov[i].iov_len;
+    }
+    return total;
+  }
+  tempfile = file_ptr (fd);
+  if (tempfile == NULL || inode_is_dir (file_get_inode (tempfile)))
+    return -1;
+  return file_writev (tempfile, iov, iov_cnt);
+}
+
+/* Copies up to LENGTH bytes from IN_FD to OUT_FD, starting at and
+   advancing each file's position, without passing the data through
+   user memory.  Returns the number of bytes copied, or -1 if either
+   fd is not an open ordinary file, both are the same fd, or both
+   name the same file and the bytes to copy overlap their
+   destination. */
+int copy_file_range (int in_fd, int out_fd, unsigned length)
+{
+  struct file *in = file_ptr (in_fd);
+  struct file *out = file_ptr (out_fd);
+  if (in == NULL || out == NULL || in == out
+      || inode_is_dir (file_get_inode (in))
+      || inode_is_dir (file_get_inode (out)))
+    return -1;
+  if (length > INT32_MAX)
+    length = INT32_MAX;
+  if (file_get_inode (in) == file_get_inode (out))
+    {
+      off_t in_pos = file_tell (in);
+      off_t out_pos = file_tell (out);
+      off_t size = file_length (in) - in_pos;
+      if (size > (off_t) length)
+        size = length;
+      if (size > 0 && out_pos < in_pos + size && in_pos < out_pos + size)
+        return -1;
+    }
+  return file_copy (in, out, length);
+}
+
+#ifdef VM
+/* Maps open file FD into memory at ADDR.  Returns the mapping's
+   identifier, or MAP_FAILED if FD is not an open ordinary file or
+   the file cannot be mapped there. */
+mapid_t mmap (int fd, void *addr)
+{
+  struct file *tempfile = file_ptr (fd);
+  if (tempfile == NULL || inode_is_dir (file_get_inode (tempfile)))
+    return MAP_FAILED;
+  return mmap_map (tempfile, addr);
+}
+
+/* Unmaps MAPPING, writing back the pages the process changed. */
+void munmap (mapid_t mapping)
+{
+  mmap_unmap (mapping);
+}
+#endif
+
 void seek (int fd, unsigned position) 
 {
-  lock_acquire(&filesys_mutex);
   struct file *tempfile;
   tempfile = file_ptr(fd);
  	if (tempfile != NULL) {
     file_seek (tempfile, position);
   }
-  lock_release(&filesys_mutex);
 }
 unsigned tell (int fd) 
 {
-  lock_acquire(&filesys_mutex);
   struct file *tempfile;
   tempfile = file_ptr(fd);
   if (tempfile == NULL) {
-    lock_release(&filesys_mutex);
     return -1;
   }
   unsigned result = file_tell(tempfile);
-  lock_release(&filesys_mutex);
   return result;
 }
 void close (int fd) 
 {
-  lock_acquire(&filesys_mutex);
    struct thread *t = thread_current();
-   struct list *templist = &(t -> fd_entries);
-   struct file_record *tempfileRd;
-   struct list_elem *e;
-   for (e = list_begin (templist); e != list_end (templist);
-           e = list_next (e))
-   {
-	  tempfileRd = list_entry(e,struct file_record, elem);
-	  if (tempfileRd->fd == fd) {
-      file_close(tempfileRd -> cfile);
-      list_remove(e);
-      free(tempfileRd);
-      break;
-		}
-   }
-  lock_release(&filesys_mutex);
+   struct file_record *tempfileRd = fileRd_ptr (fd);
+   if (tempfileRd == NULL)
+     return;
+   t->fd_table[fd] = NULL;
+   if (fd < t->fd_next)
+     t->fd_next = fd;
+   fd_release (tempfileRd);
 }
 
 struct file * file_ptr(int fd)
 {
-   struct thread *t = thread_current();
-   struct list *templist = &(t -> fd_entries);
-   struct file_record *tempfileRd;
-   struct list_elem *e;
-   if (list_empty(templist))
-      return NULL;
-   for (e = list_begin (templist); e != list_end (templist);
-           e = list_next (e))
-   {
-	  tempfileRd = list_entry(e,struct file_record, elem);
-	  if ( tempfileRd->fd == fd)
-	      {
-		return tempfileRd -> cfile;
- 	      }
-   }
-  thread_exit();
-  return NULL;
-
+   struct file_record *tempfileRd = fileRd_ptr (fd);
+   return tempfileRd != NULL ? tempfileRd -> cfile : NULL;
 }
 
 struct file_record * fileRd_ptr(int fd)
 {
  struct thread *t = thread_current();
- struct list *templist = &(t -> fd_entries);
- struct file_record *tempfileRd;
- struct list_elem *e;
- if (list_empty(templist))
+ if (fd < 2 || fd >= t->fd_cnt)
 	 return NULL;
- for (e = list_begin (templist); e != list_end (templist);
-		 e = list_next (e))
- {
-	 tempfileRd = list_entry (e, struct file_record, elem);
-	 if (tempfileRd->fd == fd)
-	 {
-		 return tempfileRd;
-	 }
- }
- return NULL;
+ return t->fd_table[fd];
 }
 
 static void parse_args(void* esp, int* argBuf, int numToParse) {
-  int i;
-  for (i = 0; i < numToParse; i++) {
-    valid_ptr(esp + ((i + 1) * 4));
-    argBuf[i] = *(int*) (esp + ((i + 1) * 4));
-  }
-} 
-
-static void valid_ptr(void* user_ptr) {
-  if (!(is_user_vaddr(user_ptr) && user_ptr > USER_VADDR_BOUND
-        && (pagedir_get_page(thread_current()->pagedir, user_ptr) != NULL))) {
-    exit(-1);
-  }
+  if (!copy_from_user (argBuf, (int *) esp + 1, numToParse * sizeof *argBuf))
+    exit (-1);
 }
-
-static void valid_buf(char* buf, unsigned size) {
-  int i;
-  valid_ptr(buf);
-  valid_ptr(buf + size - 1);
- /* for (i = 0; i < size; i++) {
-    valid_ptr(&buf[i]);
-  }*/
-}
-
-static void valid_string(void* string) {
-  valid_ptr(string);
-  while (*(uint8_t*)string != '\0') {
-    string++;
-    valid_ptr(string);
-  }
-}
-
-
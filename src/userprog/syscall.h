@@ -9,6 +9,12 @@
 
 void syscall_init (void);
 
+/* The instructions in get_user() and put_user() that touch user
+   memory.  page_fault() resumes a kernel fault on a user address
+   only if it was taken at one of these. */
+extern const char get_user_probe[];
+extern const char put_user_probe[];
+
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
@@ -26,4 +32,5 @@ void seek (int fd, unsigned position);
 unsigned tell (int fd);
 void close (int fd);
 struct file * file_ptr(int fd);
+bool fd_table_copy (struct thread *parent);
 #endif /* userprog/syscall.h */
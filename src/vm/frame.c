@@ -0,0 +1,415 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/page.h"
+
+/* Frame table.
+
+   Every frame of the user pool that holds a process's page is
+   listed here.  When the user pool runs dry, a frame is taken from
+   some page by the clock algorithm: a hand sweeps the list, giving
+   each page whose accessed bit is set a second chance by clearing
+   the bit, and evicts the first page found with the bit clear.
+
+   A read-only page of an executable is the same in every process
+   that runs it, so such a frame is entered in the shared frame
+   table, keyed by the inode and range of the file it holds, and
+   every process that faults on that range maps the one frame.  The
+   frame lists the pages that map it and is freed when the last of
+   them goes.  Evicting it unmaps it from all of them.
+
+   A frame is also shared, without being entered in that table,
+   between a process and the children it forks.  Each of their
+   writable pages is mapped read-only until one of them writes it,
+   when frame_unshare() gives the writer its own copy.
+
+   Every page that would read in as all zeros is mapped read-only
+   to the zero frame until it is written, so that zero-filled memory
+   that is only read costs no frames.  The zero frame is not in the
+   frame table, so it is never evicted, and is never freed.
+
+   FRAME_LOCK protects the list, the hand, the shared frame table,
+   and each frame's PAGES and PIN_CNT members.  A frame is pinned
+   while its page is being read in or written out, and while a
+   system call does I/O to it, so that the sweep passes over it.
+   The sweep only try-locks each page's lock, because a page's owner
+   may hold it while waiting for FRAME_LOCK. */
+
+static struct list frames;
+static struct list_elem *hand;          /* Next frame to consider. */
+static struct hash shared_frames;       /* Frames with an inode. */
+static struct frame zero_frame;         /* Page of zeros, never freed. */
+static struct lock frame_lock;
+
+static struct frame *evict (void);
+static hash_hash_func shared_hash;
+static hash_less_func shared_less;
+
+/* Initializes the frame table. */
+void
+frame_init (void)
+{
+  list_init (&frames);
+  hand = list_end (&frames);
+  if (!hash_init (&shared_frames, shared_hash, shared_less, NULL))
+    PANIC ("shared frame table creation failed");
+  zero_frame.kpage = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+  list_init (&zero_frame.pages);
+  zero_frame.pin_cnt = 1;
+  zero_frame.inode = NULL;
+  lock_init (&frame_lock);
+}
+
+/* Returns a pinned frame with no pages, evicting another page if
+   the user pool is exhausted, or a null pointer if no frame can be
+   found. */
+static struct frame *
+get_frame (void)
+{
+  struct frame *f;
+  void *kpage = palloc_get_page (PAL_USER);
+
+  if (kpage == NULL)
+    return evict ();
+
+  f = malloc (sizeof *f);
+  if (f == NULL)
+    {
+      palloc_free_page (kpage);
+      return NULL;
+    }
+  f->kpage = kpage;
+  list_init (&f->pages);
+  f->pin_cnt = 1;
+  f->inode = NULL;
+  lock_acquire (&frame_lock);
+  list_push_back (&frames, &f->elem);
+  lock_release (&frame_lock);
+  return f;
+}
+
+/* Returns a pinned frame for page P, evicting another page if the
+   user pool is exhausted, or a null pointer if no frame can be
+   found.  The caller unpins it once P is in place. */
+struct frame *
+frame_alloc (struct page *p)
+{
+  struct frame *f = get_frame ();
+
+  /* No other thread looks at the pages of a pinned frame that is
+     not in the shared frame table. */
+  if (f != NULL)
+    list_push_back (&f->pages, &p->frame_elem);
+  return f;
+}
+
+/* Adds page P, which the caller maps read-only, to the zero frame
+   and returns it pinned, as frame_alloc() does. */
+struct frame *
+frame_zero (struct page *p)
+{
+  lock_acquire (&frame_lock);
+  list_push_back (&zero_frame.pages, &p->frame_elem);
+  zero_frame.pin_cnt++;
+  lock_release (&frame_lock);
+  return &zero_frame;
+}
+
+/* Adds page P to F.  The caller holds the lock of a page already in
+   F, which keeps F from being evicted or freed meanwhile. */
+void
+frame_add (struct frame *f, struct page *p)
+{
+  lock_acquire (&frame_lock);
+  list_push_back (&f->pages, &p->frame_elem);
+  lock_release (&frame_lock);
+}
+
+/* Gives page P, whose lock the caller holds and whose frame F the
+   caller has pinned, a frame of its own.  Returns F if P is the
+   only page left in it, otherwise moves P to a new frame holding a
+   copy of F and returns that.  Either way the returned frame is
+   pinned once more, besides the caller's pin on F, so the caller
+   unpins both.  Returns a null pointer if no frame can be found. */
+struct frame *
+frame_unshare (struct frame *f, struct page *p)
+{
+  struct frame *copy;
+  bool alone;
+
+  /* Only P's own process could add a page to F, by forking, so F
+     stays unshared once it is.  The zero frame is always shared. */
+  lock_acquire (&frame_lock);
+  alone = list_size (&f->pages) == 1 && f != &zero_frame;
+  if (alone)
+    f->pin_cnt++;
+  lock_release (&frame_lock);
+  if (alone)
+    return f;
+
+  copy = get_frame ();
+  if (copy == NULL)
+    return NULL;
+  memcpy (copy->kpage, f->kpage, PGSIZE);
+  lock_acquire (&frame_lock);
+  list_remove (&p->frame_elem);
+  list_push_back (&copy->pages, &p->frame_elem);
+  lock_release (&frame_lock);
+  return copy;
+}
+
+/* Removes page P, whose lock the caller holds, from F, and frees F
+   if no other page maps it. */
+void
+frame_release (struct frame *f, struct page *p)
+{
+  struct inode *inode = NULL;
+  bool last;
+
+  lock_acquire (&frame_lock);
+  list_remove (&p->frame_elem);
+  last = list_empty (&f->pages) && f != &zero_frame;
+  if (last)
+    {
+      if (hand == &f->elem)
+        hand = list_next (hand);
+      list_remove (&f->elem);
+      if (f->inode != NULL)
+        {
+          hash_delete (&shared_frames, &f->hash_elem);
+          inode = f->inode;
+        }
+    }
+  lock_release (&frame_lock);
+
+  if (last)
+    {
+      inode_close (inode);
+      palloc_free_page (f->kpage);
+      free (f);
+    }
+}
+
+/* Keeps F from being evicted until a matching frame_unpin(). */
+void
+frame_pin (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  f->pin_cnt++;
+  lock_release (&frame_lock);
+}
+
+/* Undoes one frame_pin(). */
+void
+frame_unpin (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  ASSERT (f->pin_cnt > 0);
+  f->pin_cnt--;
+  lock_release (&frame_lock);
+}
+
+/* Looks for a shared frame holding READ_BYTES bytes of INODE at
+   OFS.  If there is one, adds page P to it and returns it pinned, as
+   frame_alloc() does; otherwise returns a null pointer. */
+struct frame *
+frame_find_shared (struct page *p, struct inode *inode, off_t ofs,
+                   size_t read_bytes)
+{
+  struct frame key;
+  struct frame *f = NULL;
+  struct hash_elem *e;
+
+  key.inode = inode;
+  key.ofs = ofs;
+  key.read_bytes = read_bytes;
+  lock_acquire (&frame_lock);
+  e = hash_find (&shared_frames, &key.hash_elem);
+  if (e != NULL)
+    {
+      f = hash_entry (e, struct frame, hash_elem);
+      list_push_back (&f->pages, &p->frame_elem);
+      f->pin_cnt++;
+    }
+  lock_release (&frame_lock);
+  return f;
+}
+
+/* Enters F, a pinned frame just filled with READ_BYTES bytes of
+   INODE at OFS, in the shared frame table, so that other processes
+   can map it.  F stays private if another process entered the same
+   range first. */
+void
+frame_share (struct frame *f, struct inode *inode, off_t ofs,
+             size_t read_bytes)
+{
+  bool inserted;
+
+  f->inode = inode_reopen (inode);
+  f->ofs = ofs;
+  f->read_bytes = read_bytes;
+  lock_acquire (&frame_lock);
+  inserted = hash_insert (&shared_frames, &f->hash_elem) == NULL;
+  if (!inserted)
+    f->inode = NULL;
+  lock_release (&frame_lock);
+  if (!inserted)
+    inode_close (inode);
+}
+
+/* Advances the clock hand and returns the frame it passed. */
+static struct frame *
+next_frame (void)
+{
+  struct frame *f;
+
+  if (hand == list_end (&frames))
+    hand = list_begin (&frames);
+  f = list_entry (hand, struct frame, elem);
+  hand = list_next (hand);
+  return f;
+}
+
+/* Try-locks every page in F.  Returns true if all were acquired,
+   otherwise releases those that were and returns false. */
+static bool
+lock_pages (struct frame *f)
+{
+  struct list_elem *e, *x;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    if (!lock_try_acquire (&list_entry (e, struct page, frame_elem)->lock))
+      {
+        for (x = list_begin (&f->pages); x != e; x = list_next (x))
+          lock_release (&list_entry (x, struct page, frame_elem)->lock);
+        return false;
+      }
+  return true;
+}
+
+/* Releases the locks of the pages in F. */
+static void
+unlock_pages (struct frame *f)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    lock_release (&list_entry (e, struct page, frame_elem)->lock);
+}
+
+/* Returns true if any page in F, whose locks the caller holds, was
+   accessed since the last sweep, clearing all their accessed
+   bits. */
+static bool
+pages_accessed_recently (struct frame *f)
+{
+  struct list_elem *e;
+  bool accessed = false;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    if (page_accessed_recently (list_entry (e, struct page, frame_elem)))
+      accessed = true;
+  return accessed;
+}
+
+/* Chooses a frame by the clock algorithm, writes out its pages, and
+   returns it pinned with no pages.  Returns a null pointer if every
+   frame is pinned or busy, or the chosen page cannot be written
+   out. */
+static struct frame *
+evict (void)
+{
+  struct frame *victim = NULL;
+  struct inode *inode = NULL;
+  struct list_elem *e;
+  size_t i, n;
+
+  lock_acquire (&frame_lock);
+  /* Two full sweeps clear every accessed bit along the way, so a
+     frame that can be evicted at all is found by then. */
+  n = 2 * list_size (&frames);
+  for (i = 0; i < n && !list_empty (&frames); i++)
+    {
+      struct frame *f = next_frame ();
+      if (f->pin_cnt > 0 || !lock_pages (f))
+        continue;
+      if (pages_accessed_recently (f))
+        {
+          unlock_pages (f);
+          continue;
+        }
+      f->pin_cnt = 1;
+      if (f->inode != NULL)
+        {
+          /* No other process may start sharing it now. */
+          hash_delete (&shared_frames, &f->hash_elem);
+          inode = f->inode;
+          f->inode = NULL;
+        }
+      victim = f;
+      break;
+    }
+  lock_release (&frame_lock);
+  if (victim == NULL)
+    return NULL;
+  inode_close (inode);
+
+  /* Write out the pages without holding FRAME_LOCK, so that other
+     processes can fault in their pages meanwhile.  Each page that a
+     process changed needs its own swap slot, even when the frame is
+     shared copy-on-write, so swap may fill up partway through.  The
+     pages written out by then no longer use the frame and leave it;
+     the rest stay mapped to it. */
+  for (e = list_begin (&victim->pages); e != list_end (&victim->pages);
+       e = list_next (e))
+    if (!page_evict (list_entry (e, struct page, frame_elem)))
+      {
+        while (list_begin (&victim->pages) != e)
+          {
+            struct list_elem *x = list_pop_front (&victim->pages);
+            lock_release (&list_entry (x, struct page, frame_elem)->lock);
+          }
+        unlock_pages (victim);
+        frame_unpin (victim);
+        return NULL;
+      }
+  while (!list_empty (&victim->pages))
+    {
+      e = list_pop_front (&victim->pages);
+      lock_release (&list_entry (e, struct page, frame_elem)->lock);
+    }
+  return victim;
+}
+
+/* Returns a hash value for the shared frame containing E. */
+static unsigned
+shared_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct frame *f = hash_entry (e, struct frame, hash_elem);
+  return (hash_bytes (&f->inode, sizeof f->inode)
+          ^ hash_int (f->ofs) ^ hash_int (f->read_bytes));
+}
+
+/* Returns true if the shared frame containing A precedes the one
+   containing B. */
+static bool
+shared_less (const struct hash_elem *a_, const struct hash_elem *b_,
+             void *aux UNUSED)
+{
+  const struct frame *a = hash_entry (a_, struct frame, hash_elem);
+  const struct frame *b = hash_entry (b_, struct frame, hash_elem);
+
+  if (a->inode != b->inode)
+    return a->inode < b->inode;
+  if (a->ofs != b->ofs)
+    return a->ofs < b->ofs;
+  return a->read_bytes < b->read_bytes;
+}
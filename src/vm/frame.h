@@ -0,0 +1,44 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+
+struct inode;
+struct page;
+
+/* A frame of user memory holding a process's page, or a read-only
+   file page shared by several processes. */
+struct frame
+  {
+    void *kpage;                /* Kernel virtual address. */
+    struct list pages;          /* Pages held in the frame. */
+    unsigned pin_cnt;           /* Not to be evicted if nonzero. */
+    struct list_elem elem;      /* Element in frame table. */
+
+    /* Identity of a shared frame: READ_BYTES bytes of INODE at OFS,
+       zero-filled to a page.  INODE is null for a private frame. */
+    struct inode *inode;
+    off_t ofs;
+    size_t read_bytes;
+    struct hash_elem hash_elem; /* Element in shared frame table. */
+  };
+
+void frame_init (void);
+struct frame *frame_alloc (struct page *);
+struct frame *frame_zero (struct page *);
+void frame_release (struct frame *, struct page *);
+void frame_add (struct frame *, struct page *);
+struct frame *frame_unshare (struct frame *, struct page *);
+void frame_pin (struct frame *);
+void frame_unpin (struct frame *);
+
+struct frame *frame_find_shared (struct page *, struct inode *, off_t ofs,
+                                 size_t read_bytes);
+void frame_share (struct frame *, struct inode *, off_t ofs,
+                  size_t read_bytes);
+
+#endif /* vm/frame.h */
@@ -0,0 +1,163 @@
+#include "vm/mmap.h"
+#include <list.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/page.h"
+
+/* A file mapped into a process's address space. */
+struct mapping
+  {
+    mapid_t id;                 /* Mapping identifier. */
+    struct file *file;          /* Own handle on the mapped file. */
+    uint8_t *addr;              /* First mapped page. */
+    size_t page_cnt;            /* Number of mapped pages. */
+    struct list_elem elem;      /* Element in thread's mappings. */
+  };
+
+static void unmap (struct mapping *);
+
+/* Maps FILE into the current process's address space at ADDR, one
+   page of the file per page of memory, with the part of the last
+   page past the end of the file zeroed.  Pages are read in only
+   when first touched.  Returns the new mapping's identifier, or
+   MAP_FAILED if ADDR is null or not page-aligned, FILE is empty,
+   the range overlaps pages already in use or the area reserved for
+   the stack, or memory runs out. */
+mapid_t
+mmap_map (struct file *file, void *addr)
+{
+  struct thread *t = thread_current ();
+  struct mapping *m;
+  off_t length = file_length (file);
+  size_t i;
+
+  if (addr == NULL || pg_ofs (addr) != 0 || length <= 0)
+    return MAP_FAILED;
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return MAP_FAILED;
+  m->file = file_reopen (file);
+  if (m->file == NULL)
+    {
+      free (m);
+      return MAP_FAILED;
+    }
+  m->id = t->next_mapid++;
+  m->addr = addr;
+  m->page_cnt = 0;
+  list_push_back (&t->mappings, &m->elem);
+
+  for (i = 0; (off_t) (i * PGSIZE) < length; i++)
+    {
+      uint8_t *upage = m->addr + i * PGSIZE;
+      size_t read_bytes = length - i * PGSIZE;
+      if (read_bytes > PGSIZE)
+        read_bytes = PGSIZE;
+
+      if (!is_user_vaddr (upage) || page_in_stack (upage)
+          || pagedir_get_page (t->pagedir, upage) != NULL
+          || page_add_file (upage, m->file, i * PGSIZE, read_bytes,
+                            true, true) == NULL)
+        {
+          unmap (m);
+          return MAP_FAILED;
+        }
+      m->page_cnt++;
+    }
+  return m->id;
+}
+
+/* Gives the current process, newly created by fork, a copy of each
+   of PARENT's mappings, with its own handle on the mapped file and
+   the same identifier.  Returns false if memory runs out; the
+   mappings copied so far are undone when the process exits. */
+bool
+mmap_copy (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  t->next_mapid = parent->next_mapid;
+  for (e = list_begin (&parent->mappings); e != list_end (&parent->mappings);
+       e = list_next (e))
+    {
+      struct mapping *pm = list_entry (e, struct mapping, elem);
+      struct mapping *m;
+      size_t i;
+
+      m = malloc (sizeof *m);
+      if (m == NULL)
+        return false;
+      m->file = file_reopen (pm->file);
+      if (m->file == NULL)
+        {
+          free (m);
+          return false;
+        }
+      m->id = pm->id;
+      m->addr = pm->addr;
+      m->page_cnt = 0;
+      list_push_back (&t->mappings, &m->elem);
+
+      for (i = 0; i < pm->page_cnt; i++)
+        {
+          if (!page_copy (parent, m->addr + i * PGSIZE, m->file))
+            return false;
+          m->page_cnt++;
+        }
+    }
+  return true;
+}
+
+/* Unmaps mapping ID of the current process, writing pages that
+   the process changed back to the file.  Returns false if there is
+   no such mapping. */
+bool
+mmap_unmap (mapid_t id)
+{
+  struct list *mappings = &thread_current ()->mappings;
+  struct list_elem *e;
+
+  for (e = list_begin (mappings); e != list_end (mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if (m->id == id)
+        {
+          unmap (m);
+          return true;
+        }
+    }
+  return false;
+}
+
+/* Unmaps all of the current process's mappings, as at exit. */
+void
+mmap_unmap_all (void)
+{
+  struct list *mappings = &thread_current ()->mappings;
+
+  while (!list_empty (mappings))
+    unmap (list_entry (list_front (mappings), struct mapping, elem));
+}
+
+/* Removes M's pages, writing back dirty ones, closes its file, and
+   frees it. */
+static void
+unmap (struct mapping *m)
+{
+  size_t i;
+
+  /* Unmap the whole range with at most one TLB flush.  The dirty
+     bits survive for page_remove() to write back. */
+  pagedir_clear_range (thread_current ()->pagedir, m->addr, m->page_cnt);
+  for (i = 0; i < m->page_cnt; i++)
+    page_remove (page_lookup (m->addr + i * PGSIZE));
+  list_remove (&m->elem);
+  file_close (m->file);
+  free (m);
+}
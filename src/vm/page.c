@@ -0,0 +1,542 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
+
+/* Supplemental page table.
+
+   Each process keeps a hash table of the pages it may touch,
+   keyed by user virtual address: the pages of its executable's
+   segments, its stack, and its memory-mapped files.  The stack
+   starts as one page and grows a page at a time as the process
+   pushes below it, up to stack_page_limit pages.  A page starts
+   out with no frame; the first access faults, and page_fault_in()
+   reads it from its backing file into a new frame and maps it.  A
+   page that would only be zeros, such as one of BSS or the stack,
+   is mapped read-only to the frame table's shared zero frame until
+   the process first writes it.
+
+   A read-only page of the executable is shared: if another process
+   running the same file already has it in a frame, the page is
+   mapped to that frame instead of being read again.
+
+   The frame table may later take the frame back.  A memory-mapped
+   page is then written to its file if dirty.  Any other page that
+   has ever been written goes to swap, and one that has not is just
+   dropped, to be read again from its file or zeroed.
+
+   Only the owning process adds, finds and removes entries, so the
+   hash table needs no lock.  The frame table reaches into other
+   processes' pages to evict them, which each page's lock guards. */
+
+/* Maximum number of pages in a process's stack.
+   Controlled by kernel command-line option "-stack=COUNT". */
+size_t stack_page_limit = STACK_PAGE_LIMIT;
+
+static struct page *find (struct hash *, const void *upage);
+static bool load (struct page *, bool write);
+static bool copy_page (struct page *, struct file *);
+static void remap (struct page *, void *kpage, bool writable);
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func page_destroy;
+
+/* Initializes the current process's page table.  Returns true if
+   successful, false if memory runs out. */
+bool
+page_table_init (void)
+{
+  struct thread *t = thread_current ();
+
+  t->has_pages = hash_init (&t->pages, page_hash, page_less, NULL);
+  return t->has_pages;
+}
+
+/* Frees the current process's page table, with the frames and swap
+   slots its pages hold.  Does nothing if page_table_init() was never
+   called or failed, as for a kernel thread. */
+void
+page_table_destroy (void)
+{
+  struct thread *t = thread_current ();
+
+  if (t->has_pages)
+    {
+      hash_destroy (&t->pages, page_destroy);
+      t->has_pages = false;
+    }
+}
+
+/* Returns the current process's page that contains UPAGE, or a null
+   pointer if there is none. */
+struct page *
+page_lookup (const void *upage)
+{
+  return find (&thread_current ()->pages, upage);
+}
+
+/* Adds a page at UPAGE to the current process whose first
+   READ_BYTES bytes are read from FILE at OFS on first access, and
+   whose remaining bytes are zero.  If MMAP is true, changes to the
+   page are written back to FILE when it is removed.  Returns the
+   new page, or a null pointer if UPAGE is already in use or memory
+   runs out. */
+struct page *
+page_add_file (void *upage, struct file *file, off_t ofs,
+               size_t read_bytes, bool writable, bool mmap)
+{
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (read_bytes <= PGSIZE);
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+  p->upage = upage;
+  p->owner = thread_current ();
+  p->writable = writable;
+  lock_init (&p->lock);
+  p->frame = NULL;
+  p->swap_slot = SWAP_NONE;
+  p->private = false;
+  p->file = file;
+  p->ofs = ofs;
+  p->read_bytes = read_bytes;
+  p->mmap = mmap;
+  if (hash_insert (&thread_current ()->pages, &p->hash_elem) != NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Removes page P from the current process, writing it back to its
+   file first if it is a dirty memory-mapped page. */
+void
+page_remove (struct page *p)
+{
+  hash_delete (&thread_current ()->pages, &p->hash_elem);
+  page_destroy (&p->hash_elem, NULL);
+}
+
+/* Gives the current process, newly created by fork, a copy of each
+   of PARENT's pages other than those of memory-mapped files, using
+   EXEFILE, its own handle on the executable, as the pages' backing
+   file.  Returns false if memory runs out. */
+bool
+page_table_copy (struct thread *parent, struct file *exefile)
+{
+  struct hash_iterator i;
+
+  hash_first (&i, &parent->pages);
+  while (hash_next (&i))
+    {
+      struct page *pp = hash_entry (hash_cur (&i), struct page, hash_elem);
+      if (!pp->mmap && !copy_page (pp, exefile))
+        return false;
+    }
+  return true;
+}
+
+/* Gives the current process, newly created by fork, a copy of
+   PARENT's memory-mapped page at UPAGE, backed by FILE, its own
+   handle on the mapped file.  Returns false if memory runs out. */
+bool
+page_copy (struct thread *parent, void *upage, struct file *file)
+{
+  struct page *pp = find (&parent->pages, upage);
+
+  ASSERT (pp != NULL && pp->mmap);
+  return copy_page (pp, file);
+}
+
+/* Handles a write to the page containing FAULT_ADDR, which is
+   mapped read-only because the current process shares its frame
+   with a process it forked or was forked from, or because it is
+   mapped to the zero frame, by giving the process a writable copy
+   of the frame.  Returns true if
+   successful, false if the process may not write the page or no
+   frame can be found. */
+bool
+page_copy_on_write (const void *fault_addr)
+{
+  struct page *p;
+  bool success = true;
+
+  if (!is_user_vaddr (fault_addr))
+    return false;
+  p = page_lookup (fault_addr);
+  if (p == NULL || !p->writable || p->mmap)
+    return false;
+
+  lock_acquire (&p->lock);
+  /* If the frame was evicted meanwhile, the retried access faults
+     the page back in on its own. */
+  if (p->frame != NULL)
+    {
+      struct frame *f = p->frame;
+      struct frame *copy;
+
+      frame_pin (f);
+      copy = frame_unshare (f, p);
+      if (copy != NULL)
+        {
+          remap (p, copy->kpage, true);
+          p->frame = copy;
+          p->private = true;
+          frame_unpin (copy);
+        }
+      else
+        success = false;
+      frame_unpin (f);
+    }
+  lock_release (&p->lock);
+  return success;
+}
+
+/* Brings in the page containing FAULT_ADDR, which the current
+   process touched but which is not mapped.  WRITE is true if the
+   access was a write.  Returns true if successful, false if the
+   address is not part of any page or the page cannot be loaded. */
+bool
+page_fault_in (const void *fault_addr, bool write)
+{
+  struct page *p;
+  bool success = true;
+
+  if (!is_user_vaddr (fault_addr))
+    return false;
+  p = page_lookup (fault_addr);
+  if (p == NULL)
+    return false;
+
+  lock_acquire (&p->lock);
+  if (p->frame == NULL)
+    {
+      success = load (p, write);
+      if (success)
+        frame_unpin (p->frame);
+    }
+  lock_release (&p->lock);
+  return success;
+}
+
+/* Extends the current process's stack down to FAULT_ADDR and
+   brings in the new page, if FAULT_ADDR looks like a stack access
+   by a process whose stack pointer is ESP: no more than 32 bytes
+   below ESP, since PUSHA checks its whole destination before moving
+   ESP, and within the area reserved for the stack.  Returns true if
+   successful, false if FAULT_ADDR is not a stack access or memory
+   runs out. */
+bool
+page_grow_stack (const void *fault_addr, const void *esp)
+{
+  if (!page_in_stack (fault_addr)
+      || (const uint8_t *) fault_addr < (const uint8_t *) esp - 32)
+    return false;
+  return (page_add_file (pg_round_down (fault_addr), NULL, 0, 0, true, false)
+          != NULL
+          && page_fault_in (fault_addr, true));
+}
+
+/* Returns true if user address UADDR lies within the
+   stack_page_limit pages below PHYS_BASE reserved for the stack. */
+bool
+page_in_stack (const void *uaddr)
+{
+  return (is_user_vaddr (uaddr)
+          && (size_t) ((const uint8_t *) PHYS_BASE
+                       - (const uint8_t *) uaddr) <= stack_page_limit * PGSIZE);
+}
+
+/* Brings in the page containing user address UADDR, if needed, and
+   keeps it in memory until page_unpin(), so that a system call can
+   do I/O to it while holding file system locks.  Returns false if
+   UADDR is not in any page or the page cannot be loaded. */
+bool
+page_pin (const void *uaddr)
+{
+  struct page *p = page_lookup (uaddr);
+  bool success = true;
+
+  if (p == NULL)
+    return false;
+  lock_acquire (&p->lock);
+  if (p->frame == NULL)
+    success = load (p, false);
+  else
+    frame_pin (p->frame);
+  lock_release (&p->lock);
+  return success;
+}
+
+/* Lets the page containing UADDR, pinned by page_pin(), be evicted
+   again. */
+void
+page_unpin (const void *uaddr)
+{
+  struct page *p = page_lookup (uaddr);
+
+  ASSERT (p != NULL);
+  lock_acquire (&p->lock);
+  if (p->frame != NULL)
+    frame_unpin (p->frame);
+  lock_release (&p->lock);
+}
+
+/* Returns true if P's accessed bit is set, clearing it.  The caller
+   holds P's lock and P is in a frame. */
+bool
+page_accessed_recently (struct page *p)
+{
+  uint32_t *pd = p->owner->pagedir;
+
+  if (pagedir_is_accessed (pd, p->upage))
+    {
+      pagedir_set_accessed (pd, p->upage, false);
+      return true;
+    }
+  return false;
+}
+
+/* Unmaps P, which is in a pinned frame and whose lock the caller
+   holds, and saves its contents so that the frame can be reused.
+   Returns false, leaving P in place, if P must go to swap but swap
+   is full. */
+bool
+page_evict (struct page *p)
+{
+  uint32_t *pd = p->owner->pagedir;
+  void *kpage = p->frame->kpage;
+
+  /* Unmap first, so that the owner cannot change the page while it
+     is written out.  The dirty bit survives in the PTE. */
+  pagedir_clear_page (pd, p->upage);
+  if (pagedir_is_dirty (pd, p->upage))
+    p->private = true;
+
+  if (p->mmap)
+    {
+      if (p->private)
+        file_write_at (p->file, kpage, p->read_bytes, p->ofs);
+      p->private = false;
+    }
+  else if (p->private)
+    {
+      p->swap_slot = swap_out (kpage);
+      if (p->swap_slot == SWAP_NONE)
+        {
+          pagedir_set_page (pd, p->upage, kpage, p->writable);
+          pagedir_set_dirty (pd, p->upage, true);
+          return false;
+        }
+    }
+  p->frame = NULL;
+  return true;
+}
+
+/* Maps P, whose lock the caller holds and which is mapped now, to
+   KPAGE instead, writable only if WRITABLE is true.  The page table
+   that holds P's entry already exists, so this cannot fail. */
+static void
+remap (struct page *p, void *kpage, bool writable)
+{
+  uint32_t *pd = p->owner->pagedir;
+
+  pagedir_clear_page (pd, p->upage);
+  pagedir_set_page (pd, p->upage, kpage, writable);
+}
+
+/* Adds a copy of page PP of the forking process to the current
+   process, backed by FILE if PP has a file.  If PP is in a frame,
+   the copy shares it: a memory-mapped page stays writable in both
+   processes, so both see each other's changes until they write
+   them back, and any other writable page becomes read-only in both
+   until one of them writes it.  A page in swap is read in first, so
+   that it can be shared the same way.  Returns false if memory runs
+   out. */
+static bool
+copy_page (struct page *pp, struct file *file)
+{
+  struct page *p;
+  bool loaded = false;
+  bool success = true;
+
+  p = page_add_file (pp->upage, pp->file != NULL ? file : NULL, pp->ofs,
+                     pp->read_bytes, pp->writable, pp->mmap);
+  if (p == NULL)
+    return false;
+
+  lock_acquire (&pp->lock);
+  if (pp->frame == NULL && pp->swap_slot != SWAP_NONE)
+    success = loaded = load (pp, false);
+  if (success && pp->frame != NULL)
+    {
+      uint32_t *pd = pp->owner->pagedir;
+      struct frame *f = pp->frame;
+
+      if (pp->writable && !pp->mmap)
+        {
+          /* Mapping the frame again loses the dirty bit. */
+          if (pagedir_is_dirty (pd, pp->upage))
+            pp->private = true;
+          remap (pp, f->kpage, false);
+        }
+      frame_add (f, p);
+      if (pagedir_set_page (p->owner->pagedir, p->upage, f->kpage, pp->mmap))
+        p->frame = f;
+      else
+        {
+          frame_release (f, p);
+          success = false;
+        }
+    }
+  p->private = pp->private;
+  if (loaded)
+    frame_unpin (pp->frame);
+  lock_release (&pp->lock);
+  return success;
+}
+
+/* Returns true if P can share its frame with the same page of
+   other processes, which is so for a read-only page of a file that
+   is not mapped with mmap. */
+static bool
+shareable (const struct page *p)
+{
+  return !p->writable && !p->mmap && p->file != NULL;
+}
+
+/* Returns true if P, which is not in a frame, would read in as all
+   zeros. */
+static bool
+all_zeros (const struct page *p)
+{
+  return p->read_bytes == 0 && p->swap_slot == SWAP_NONE && !p->mmap;
+}
+
+/* Reads P, whose lock the caller holds, into a new frame and maps
+   it.  A shareable page that another process already has in a
+   frame is mapped to that frame instead, and a page of zeros that
+   is not being written, as WRITE says, is mapped read-only to the
+   zero frame.  Returns true with the frame pinned if successful. */
+static bool
+load (struct page *p, bool write)
+{
+  struct inode *inode = NULL;
+  struct frame *f = NULL;
+  bool writable = p->writable;
+  uint8_t *kpage;
+
+  if (!write && all_zeros (p))
+    {
+      /* A write faults, and page_copy_on_write() then gives the page
+         a frame of its own. */
+      f = frame_zero (p);
+      writable = false;
+    }
+  else if (shareable (p))
+    {
+      inode = file_get_inode (p->file);
+      f = frame_find_shared (p, inode, p->ofs, p->read_bytes);
+    }
+  if (f == NULL)
+    {
+      f = frame_alloc (p);
+      if (f == NULL)
+        return false;
+      kpage = f->kpage;
+      if (p->swap_slot != SWAP_NONE)
+        {
+          swap_in (p->swap_slot, kpage);
+          p->swap_slot = SWAP_NONE;
+        }
+      else
+        {
+          if (p->read_bytes > 0
+              && file_read_at (p->file, kpage, p->read_bytes, p->ofs)
+                 != (off_t) p->read_bytes)
+            {
+              frame_release (f, p);
+              return false;
+            }
+          memset (kpage + p->read_bytes, 0, PGSIZE - p->read_bytes);
+          if (inode != NULL)
+            frame_share (f, inode, p->ofs, p->read_bytes);
+        }
+    }
+
+  if (!pagedir_set_page (p->owner->pagedir, p->upage, f->kpage, writable))
+    {
+      frame_unpin (f);
+      frame_release (f, p);
+      return false;
+    }
+  p->frame = f;
+  return true;
+}
+
+/* Returns the page in page table PAGES that contains UPAGE, or a
+   null pointer if there is none. */
+static struct page *
+find (struct hash *pages, const void *upage)
+{
+  struct page p;
+  struct hash_elem *e;
+
+  p.upage = pg_round_down (upage);
+  e = hash_find (pages, &p.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Returns a hash value for the page containing E. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return hash_bytes (&p->upage, sizeof p->upage);
+}
+
+/* Returns true if the page containing A precedes the one
+   containing B. */
+static bool
+page_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED)
+{
+  const struct page *pa = hash_entry (a, struct page, hash_elem);
+  const struct page *pb = hash_entry (b, struct page, hash_elem);
+  return pa->upage < pb->upage;
+}
+
+/* Frees the page containing E, with its frame or swap slot,
+   writing it back to its file first if it is a dirty
+   memory-mapped page. */
+static void
+page_destroy (struct hash_elem *e, void *aux UNUSED)
+{
+  struct page *p = hash_entry (e, struct page, hash_elem);
+  uint32_t *pd = p->owner->pagedir;
+
+  /* Waits for the frame table to finish with the page, if it is
+     evicting it. */
+  lock_acquire (&p->lock);
+  if (p->frame != NULL)
+    {
+      pagedir_clear_page (pd, p->upage);
+      if (p->mmap && pagedir_is_dirty (pd, p->upage))
+        file_write_at (p->file, p->frame->kpage, p->read_bytes, p->ofs);
+      frame_release (p->frame, p);
+    }
+  else if (p->swap_slot != SWAP_NONE)
+    swap_free (p->swap_slot);
+  lock_release (&p->lock);
+  free (p);
+}
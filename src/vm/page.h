@@ -0,0 +1,65 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+#include "threads/synch.h"
+
+struct file;
+
+/* Default maximum size of a process's stack, in pages (8 MB). */
+#define STACK_PAGE_LIMIT 2048
+
+extern size_t stack_page_limit;
+
+/* A page of a process's virtual address space, as recorded in its
+   supplemental page table.  Each page that the process may touch
+   has one of these, whether or not it is in memory, so that a
+   page fault can tell how to bring it in. */
+struct page
+  {
+    void *upage;                /* User virtual address. */
+    struct thread *owner;       /* Process whose page it is. */
+    bool writable;              /* May the process write it? */
+
+    /* Held while the page is brought in, written out, or freed.
+       Protects FRAME, SWAP_SLOT and PRIVATE. */
+    struct lock lock;
+    struct frame *frame;        /* Frame holding it, or null. */
+    struct list_elem frame_elem; /* Element in frame's page list. */
+    size_t swap_slot;           /* Swap slot holding it, or SWAP_NONE. */
+    bool private;               /* Changed from its file or zeros? */
+
+    /* Backing file.  The first READ_BYTES bytes of the page come
+       from FILE at OFS and the rest are zero.  A page with no bytes
+       to read, such as one of BSS, needs no file. */
+    struct file *file;
+    off_t ofs;
+    size_t read_bytes;
+    bool mmap;                  /* Write back to FILE when dirty? */
+
+    struct hash_elem hash_elem; /* Element in thread's page table. */
+  };
+
+bool page_table_init (void);
+void page_table_destroy (void);
+bool page_table_copy (struct thread *parent, struct file *exefile);
+bool page_copy (struct thread *parent, void *upage, struct file *);
+struct page *page_lookup (const void *upage);
+struct page *page_add_file (void *upage, struct file *, off_t ofs,
+                            size_t read_bytes, bool writable, bool mmap);
+void page_remove (struct page *);
+bool page_fault_in (const void *fault_addr, bool write);
+bool page_grow_stack (const void *fault_addr, const void *esp);
+bool page_in_stack (const void *uaddr);
+bool page_copy_on_write (const void *fault_addr);
+bool page_pin (const void *uaddr);
+void page_unpin (const void *uaddr);
+
+/* For the frame table. */
+bool page_accessed_recently (struct page *);
+bool page_evict (struct page *);
+
+#endif /* vm/page.h */
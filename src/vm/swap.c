@@ -0,0 +1,78 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include "devices/block.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Swap partition.
+
+   The swap device is divided into page-sized slots, with a bitmap
+   recording which slots hold a page.  A page is written to a free
+   slot when its frame is taken and read back, freeing the slot,
+   when it is next touched. */
+
+/* Sectors per swap slot. */
+#define SLOT_SECTORS (PGSIZE / BLOCK_SECTOR_SIZE)
+
+static struct block *swap_device;
+static struct bitmap *used_slots;       /* Slots that hold a page. */
+static struct lock swap_lock;           /* Protects USED_SLOTS. */
+
+/* Finds the swap device and sets up its slot bitmap.  Without a
+   swap device, every swap_out() fails. */
+void
+swap_init (void)
+{
+  size_t slot_cnt = 0;
+
+  lock_init (&swap_lock);
+  swap_device = block_get_role (BLOCK_SWAP);
+  if (swap_device != NULL)
+    slot_cnt = block_size (swap_device) / SLOT_SECTORS;
+  used_slots = bitmap_create (slot_cnt);
+  if (used_slots == NULL)
+    PANIC ("swap bitmap creation failed");
+}
+
+/* Writes the page at KPAGE to a free swap slot and returns the
+   slot, or SWAP_NONE if swap is full. */
+size_t
+swap_out (const void *kpage)
+{
+  size_t slot;
+  size_t i;
+
+  lock_acquire (&swap_lock);
+  slot = bitmap_scan_and_flip (used_slots, 0, 1, false);
+  lock_release (&swap_lock);
+  if (slot == BITMAP_ERROR)
+    return SWAP_NONE;
+
+  for (i = 0; i < SLOT_SECTORS; i++)
+    block_write (swap_device, slot * SLOT_SECTORS + i,
+                 (const uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+  return slot;
+}
+
+/* Reads the page in swap SLOT into KPAGE and frees the slot. */
+void
+swap_in (size_t slot, void *kpage)
+{
+  size_t i;
+
+  for (i = 0; i < SLOT_SECTORS; i++)
+    block_read (swap_device, slot * SLOT_SECTORS + i,
+                (uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+  swap_free (slot);
+}
+
+/* Frees swap SLOT without reading it. */
+void
+swap_free (size_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  bitmap_reset (used_slots, slot);
+  lock_release (&swap_lock);
+}
@@ -0,0 +1,14 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <stddef.h>
+
+/* Swap slot of a page that is not in swap. */
+#define SWAP_NONE ((size_t) -1)
+
+void swap_init (void);
+size_t swap_out (const void *kpage);
+void swap_in (size_t slot, void *kpage);
+void swap_free (size_t slot);
+
+#endif /* vm/swap.h */